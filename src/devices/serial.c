@@ -1,7 +1,7 @@
 #include "devices/serial.h"
 #include <debug.h>
+#include <string.h>
 #include "devices/input.h"
-#include "devices/intq.h"
 #include "devices/timer.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
@@ -33,6 +33,17 @@
 #define MCR_REG (IO_BASE + 4)   /* MODEM Control Register. */
 #define LSR_REG (IO_BASE + 5)   /* Line Status Register (read-only). */
 
+/* Interrupt Identification Register bits. */
+#define IIR_FIFO 0xc0           /* FIFOs enabled (16550A and later). */
+
+/* FIFO Control Register bits. */
+#define FCR_ENABLE 0x01         /* Enable FIFOs. */
+#define FCR_CLEAR 0x06          /* Clear receive and transmit FIFOs. */
+#define FCR_TRIG_1 0x00         /* Receive interrupt after 1 byte. */
+
+/* Depth of the 16550A transmit FIFO. */
+#define XMIT_FIFO_SIZE 16
+
 /* Interrupt Enable Register bits. */
 #define IER_RECV 0x01           /* Interrupt when data received. */
 #define IER_XMIT 0x02           /* Interrupt when transmit finishes. */
@@ -51,11 +62,37 @@
 /* Transmission mode. */
 static enum { UNINIT, POLL, QUEUE } mode;
 
-/* Data to be transmitted. */
-static struct intq txq;
+/* Data to be transmitted: a ring of TXQ_SIZE bytes, which must
+   be a power of 2.  txq_head and txq_tail count the bytes ever
+   queued and ever sent, so byte N is at txq_buf[N % TXQ_SIZE].
+   Accessed only with interrupts off.
+
+   The ring is much larger than an intq so that a burst of
+   console output can be queued in full and sent from the
+   interrupt handler, instead of making the writer wait or, with
+   interrupts off, fall back to polling. */
+#ifndef TXQ_SIZE
+#define TXQ_SIZE 8192
+#endif
+#if TXQ_SIZE <= 0 || (TXQ_SIZE & (TXQ_SIZE - 1)) != 0
+#error TXQ_SIZE must be a power of 2
+#endif
+static uint8_t txq_buf[TXQ_SIZE];
+static uint32_t txq_head;
+static uint32_t txq_tail;
+
+/* Thread waiting for room in the ring, if any, and a lock that
+   lets only one thread wait at a time.  As for an intq. */
+static struct lock txq_lock;
+static struct thread *txq_waiter;
+
+/* Number of bytes that may be written to THR at once after it
+   reports empty: the FIFO depth on a 16550A, otherwise 1. */
+static int xmit_burst;
 
 static void set_serial (int bps);
 static void putc_poll (uint8_t);
+static void xmit (void);
 static void write_ier (void);
 static intr_handler_func serial_interrupt;
 
@@ -68,10 +105,15 @@ init_poll (void)
 {
   ASSERT (mode == UNINIT);
   outb (IER_REG, 0);                    /* Turn off all interrupts. */
-  outb (FCR_REG, 0);                    /* Disable FIFO. */
+  outb (FCR_REG, FCR_ENABLE | FCR_CLEAR | FCR_TRIG_1);
   set_serial (9600);                    /* 9.6 kbps, N-8-1. */
   outb (MCR_REG, MCR_OUT2);             /* Required to enable interrupts. */
-  intq_init (&txq);
+
+  /* Only a 16550A reports working FIFOs.  Older UARTs ignore
+     FCR and hold a single byte. */
+  xmit_burst = (inb (IIR_REG) & IIR_FIFO) == IIR_FIFO ? XMIT_FIFO_SIZE : 1;
+
+  lock_init (&txq_lock);
   mode = POLL;
 } 
 
@@ -94,35 +136,85 @@ serial_init_queue (void)
   intr_set_level (old_level);
 }
 
+/* Returns the number of bytes waiting to be transmitted. */
+static size_t
+txq_len (void) 
+{
+  return txq_head - txq_tail;
+}
+
 /* Sends BYTE to the serial port. */
 void
 serial_putc (uint8_t byte) 
 {
+  serial_putbuf (&byte, 1);
+}
+
+/* Sends the N bytes in BUFFER to the serial port, queuing as many
+   at a time as the transmit ring has room for.  BUFFER is copied
+   with interrupts off, so it must be kernel memory, never a user
+   buffer that could page fault. */
+void
+serial_putbuf (const void *buffer_, size_t n) 
+{
+  const uint8_t *buffer = buffer_;
   enum intr_level old_level = intr_disable ();
 
   if (mode != QUEUE)
     {
       /* If we're not set up for interrupt-driven I/O yet,
-         use dumb polling to transmit a byte. */
+         use dumb polling to transmit. */
       if (mode == UNINIT)
         init_poll ();
-      putc_poll (byte); 
+      while (n-- > 0)
+        putc_poll (*buffer++); 
     }
   else 
     {
-      /* Otherwise, queue a byte and update the interrupt enable
-         register. */
-      if (old_level == INTR_OFF && intq_full (&txq)) 
+      while (n > 0) 
         {
-          /* Interrupts are off and the transmit queue is full.
-             If we wanted to wait for the queue to empty,
-             we'd have to reenable interrupts.
-             That's impolite, so we'll send a character via
-             polling instead. */
-          putc_poll (intq_getc (&txq)); 
+          size_t room = TXQ_SIZE - txq_len ();
+          size_t ofs = txq_head % TXQ_SIZE;
+          size_t chunk;
+
+          if (room == 0) 
+            {
+              if (old_level == INTR_OFF || intr_context ()) 
+                {
+                  /* Interrupts are off and the transmit ring is
+                     full.  If we wanted to wait for it to
+                     empty, we'd have to reenable interrupts.
+                     That's impolite, so we'll send a FIFO's
+                     worth via polling instead. */
+                  while ((inb (LSR_REG) & LSR_THRE) == 0)
+                    continue;
+                  xmit ();
+                }
+              else 
+                {
+                  /* Wait for the interrupt handler to make
+                     room. */
+                  write_ier ();
+                  lock_acquire (&txq_lock);
+                  while (txq_len () == TXQ_SIZE) 
+                    {
+                      txq_waiter = thread_current ();
+                      thread_block ();
+                    }
+                  lock_release (&txq_lock);
+                }
+              continue;
+            }
+
+          /* Copy as much as fits before the end of the ring. */
+          chunk = n < room ? n : room;
+          if (chunk > TXQ_SIZE - ofs)
+            chunk = TXQ_SIZE - ofs;
+          memcpy (txq_buf + ofs, buffer, chunk);
+          txq_head += chunk;
+          buffer += chunk;
+          n -= chunk;
         }
-
-      intq_putc (&txq, byte); 
       write_ier ();
     }
   
@@ -135,8 +227,8 @@ void
 serial_flush (void) 
 {
   enum intr_level old_level = intr_disable ();
-  while (!intq_empty (&txq))
-    putc_poll (intq_getc (&txq));
+  while (txq_len () > 0)
+    putc_poll (txq_buf[txq_tail++ % TXQ_SIZE]);
   intr_set_level (old_level);
 }
 
@@ -182,7 +274,7 @@ write_ier (void)
 
   /* Enable transmit interrupt if we have any characters to
      transmit. */
-  if (!intq_empty (&txq))
+  if (txq_len () > 0)
     ier |= IER_XMIT;
 
   /* Enable receive interrupt if we have room to store any
@@ -205,6 +297,26 @@ putc_poll (uint8_t byte)
   outb (THR_REG, byte);
 }
 
+/* Moves up to one FIFO's worth of bytes from the transmit ring
+   to the UART, which must have reported THR empty, and wakes any
+   thread waiting for room. */
+static void
+xmit (void) 
+{
+  int i;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (i = 0; i < xmit_burst && txq_len () > 0; i++)
+    outb (THR_REG, txq_buf[txq_tail++ % TXQ_SIZE]);
+
+  if (i > 0 && txq_waiter != NULL) 
+    {
+      thread_unblock (txq_waiter);
+      txq_waiter = NULL;
+    }
+}
+
 /* Serial interrupt handler. */
 static void
 serial_interrupt (struct intr_frame *f UNUSED) 
@@ -218,10 +330,11 @@ serial_interrupt (struct intr_frame *f UNUSED)
   while (!input_full () && (inb (LSR_REG) & LSR_DR) != 0)
     input_putc (inb (RBR_REG));
 
-  /* As long as we have a byte to transmit, and the hardware is
-     ready to accept a byte for transmission, transmit a byte. */
-  while (!intq_empty (&txq) && (inb (LSR_REG) & LSR_THRE) != 0) 
-    outb (THR_REG, intq_getc (&txq));
+  /* If the hardware is ready to accept bytes for transmission,
+     fill its FIFO.  THRE means the whole FIFO is empty, so one
+     check covers the burst. */
+  if (txq_len () > 0 && (inb (LSR_REG) & LSR_THRE) != 0) 
+    xmit ();
 
   /* Update interrupt enable register based on queue status. */
   write_ier ();
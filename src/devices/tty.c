@@ -0,0 +1,118 @@
+#include "devices/tty.h"
+#include <console.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/input.h"
+#include "threads/synch.h"
+
+/* Line discipline for console input.
+
+   Keys from devices/input.c are collected into a line buffer and
+   edited there, with echo, until the user finishes the line.  Only
+   then does the line become available to readers, who take as
+   much of it as they asked for in one copy.  This is "cooked"
+   mode in Unix terms:
+
+        Enter           Finishes the line, which ends in '\n'.
+        Backspace, Del  Erases the last character.
+        Ctrl+U          Erases the whole line.
+        Ctrl+D          Finishes the line without a new-line; at
+                        the start of a line, signals end of file.
+
+   A line that fills the buffer is finished as if Enter had been
+   pressed. */
+
+#define LINE_MAX TTY_LINE_MAX            /* Line buffer size. */
+#define CTRL(KEY) ((KEY) - 'A' + 1)
+
+static struct lock tty_lock;            /* One reader at a time. */
+static char line[LINE_MAX];             /* Line being edited or read. */
+static size_t line_len;                 /* Bytes in line. */
+static size_t line_ofs;                 /* Bytes already read. */
+
+static void read_line (void);
+
+/* Initializes the line discipline. */
+void
+tty_init (void) 
+{
+  lock_init (&tty_lock);
+}
+
+/* Reads up to SIZE bytes of console input into BUFFER.  Waits for
+   a complete line if none is pending, then returns as much of it
+   as fits.  Returns 0 at end of file, or at once if SIZE is 0. */
+size_t
+tty_read (void *buffer, size_t size) 
+{
+  size_t n;
+
+  /* Don't wait for a line that nothing will be read from. */
+  if (size == 0)
+    return 0;
+
+  lock_acquire (&tty_lock);
+  if (line_ofs == line_len)
+    read_line ();
+
+  n = line_len - line_ofs;
+  if (n > size)
+    n = size;
+  memcpy (buffer, line + line_ofs, n);
+  line_ofs += n;
+  lock_release (&tty_lock);
+
+  return n;
+}
+
+/* Erases the last character of the line being edited.
+   Returns true if there was one. */
+static bool
+erase (void) 
+{
+  if (line_len == 0)
+    return false;
+  line_len--;
+  putbuf ("\b \b", 3);
+  return true;
+}
+
+/* Reads and edits keys until a line is complete. */
+static void
+read_line (void) 
+{
+  line_len = line_ofs = 0;
+  while (line_len < LINE_MAX)
+    {
+      uint8_t c = input_getc ();
+
+      switch (c) 
+        {
+        case '\r':
+        case '\n':
+          line[line_len++] = '\n';
+          putchar ('\n');
+          return;
+
+        case '\b':
+        case 0x7f:
+          erase ();
+          break;
+
+        case CTRL ('U'):
+          while (erase ())
+            continue;
+          break;
+
+        case CTRL ('D'):
+          return;
+
+        default:
+          line[line_len++] = c;
+          putchar (c);
+          break;
+        }
+    }
+}
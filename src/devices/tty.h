@@ -0,0 +1,12 @@
+#ifndef DEVICES_TTY_H
+#define DEVICES_TTY_H
+
+#include <stddef.h>
+
+/* Longest line tty_read() returns in one call. */
+#define TTY_LINE_MAX 256
+
+void tty_init (void);
+size_t tty_read (void *, size_t);
+
+#endif /* devices/tty.h */
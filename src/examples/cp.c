@@ -9,6 +9,7 @@ int
 main (int argc, char *argv[]) 
 {
   int in_fd, out_fd;
+  int size, copied, n;
 
   if (argc != 3) 
     {
@@ -25,7 +26,8 @@ main (int argc, char *argv[])
     }
 
   /* Create and open output file. */
-  if (!create (argv[2], filesize (in_fd))) 
+  size = filesize (in_fd);
+  if (!create (argv[2], size)) 
     {
       printf ("%s: create failed\n", argv[2]);
       return EXIT_FAILURE;
@@ -37,14 +39,14 @@ main (int argc, char *argv[])
       return EXIT_FAILURE;
     }
 
-  /* Copy data. */
-  for (;;) 
+  /* Copy data inside the kernel, which may copy less than asked
+     for at a time.  It returns 0 at the end of the input. */
+  for (copied = 0; copied < size; copied += n)
     {
-      char buffer[1024];
-      int bytes_read = read (in_fd, buffer, sizeof buffer);
-      if (bytes_read == 0)
+      n = copy_file_range (in_fd, out_fd, size - copied);
+      if (n == 0)
         break;
-      if (write (out_fd, buffer, bytes_read) != bytes_read) 
+      if (n < 0)
         {
           printf ("%s: write failed\n", argv[2]);
           return EXIT_FAILURE;
@@ -4,7 +4,6 @@
 #include <syscall.h>
 
 static void read_line (char line[], size_t);
-static bool backspace (char **pos, char line[]);
 
 int
 main (void)
@@ -45,60 +44,27 @@ main (void)
 }
 
 /* Reads a line of input from the user into LINE, which has room
-   for SIZE bytes.  Handles backspace and Ctrl+U in the ways
-   expected by Unix users.  On return, LINE will always be
-   null-terminated and will not end in a new-line character. */
+   for SIZE bytes.  The kernel's line discipline handles echo,
+   backspace and Ctrl+U, so a whole line arrives in one read; any
+   part of a line too long for LINE is discarded.  On return, LINE
+   will always be null-terminated and will not end in a new-line
+   character. */
 static void
 read_line (char line[], size_t size) 
 {
-  char *pos = line;
-  for (;;)
-    {
-      char c;
-      read (STDIN_FILENO, &c, 1);
-
-      switch (c) 
-        {
-        case '\r':
-          *pos = '\0';
-          putchar ('\n');
-          return;
-
-        case '\b':
-          backspace (&pos, line);
-          break;
+  int n = read (STDIN_FILENO, line, size - 1);
+  bool complete = n <= 0 || line[n - 1] == '\n';
 
-        case ('U' - 'A') + 1:       /* Ctrl+U. */
-          while (backspace (&pos, line))
-            continue;
-          break;
+  if (n < 0)
+    n = 0;
+  if (n > 0 && line[n - 1] == '\n')
+    n--;
+  line[n] = '\0';
 
-        default:
-          /* Add character to line. */
-          if (pos < line + size - 1) 
-            {
-              putchar (c);
-              *pos++ = c;
-            }
-          break;
-        }
-    }
-}
-
-/* If *POS is past the beginning of LINE, backs up one character
-   position.  Returns true if successful, false if nothing was
-   done. */
-static bool
-backspace (char **pos, char line[]) 
-{
-  if (*pos > line)
+  /* Drain the rest of an overlong line. */
+  while (!complete)
     {
-      /* Back up cursor, overwrite character, back up
-         again. */
-      printf ("\b \b");
-      (*pos)--;
-      return true;
+      char c;
+      complete = read (STDIN_FILENO, &c, 1) <= 0 || c == '\n';
     }
-  else
-    return false;
 }
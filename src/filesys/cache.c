@@ -10,7 +10,9 @@ struct cache_entry {
 	bool valid;  
 	bool dirty;     
 	bool reference;
+	bool pinned;    /* Logged by an uncommitted journal transaction. */
 	block_sector_t sector;
+	block_sector_t owner;  /* Inode whose data this is, or CACHE_NO_OWNER. */
 	uint8_t buffer[BLOCK_SECTOR_SIZE];
 
 };
@@ -23,8 +25,10 @@ void buffer_cache_init(void)
 {
 	clock_idx = 0;
 	lock_init(&cache_lock);
-	for (size_t i = 0; i < CACHE_SIZE; ++i)
+	for (size_t i = 0; i < CACHE_SIZE; ++i) {
 		cache[i].valid = false;
+		cache[i].pinned = false;
+	}
 }
 
 void buffer_cache_flush_entry(struct cache_entry *entry)
@@ -35,19 +39,43 @@ void buffer_cache_flush_entry(struct cache_entry *entry)
 	}
 }
 
-void buffer_cache_terminate(void)
+/* Writes every dirty entry back to disk.
+   Pinned entries hold uncommitted journal data and are left
+   alone; the journal writes them once they commit. */
+void buffer_cache_flush_all(void)
+{
+	lock_acquire(&cache_lock);
+
+	for (size_t i = 0; i < CACHE_SIZE; ++i)
+	{
+		if (cache[i].valid == true && !cache[i].pinned)
+			buffer_cache_flush_entry(&(cache[i]));
+	}
+
+	lock_release(&cache_lock);
+}
+
+/* Writes back only the dirty data sectors of the inode at sector
+   OWNER. */
+void buffer_cache_flush_owner(block_sector_t owner)
 {
 	lock_acquire(&cache_lock);
 
 	for (size_t i = 0; i < CACHE_SIZE; ++i)
 	{
-		if (cache[i].valid == true)
+		if (cache[i].valid == true && !cache[i].pinned
+			&& cache[i].owner == owner)
 			buffer_cache_flush_entry(&(cache[i]));
 	}
 
 	lock_release(&cache_lock);
 }
 
+void buffer_cache_terminate(void)
+{
+	buffer_cache_flush_all();
+}
+
 
 struct cache_entry* buffer_cache_lookup(block_sector_t sector)
 {
@@ -68,6 +96,9 @@ struct cache_entry* buffer_cache_select_victim(void)
 		if (!cache[clock_idx].valid)
 			return &cache[clock_idx];
 
+		else if (cache[clock_idx].pinned)
+			;  /* Must not reach disk before its transaction commits. */
+
 		else if (cache[clock_idx].reference)
 			cache[clock_idx].reference = false;
 
@@ -94,7 +125,9 @@ void buffer_cache_read(block_sector_t sector, void *buffer)
 		e = buffer_cache_select_victim();
 		e->valid = true;
 		e->dirty = false;
+		e->pinned = false;
 		e->sector = sector;
+		e->owner = CACHE_NO_OWNER;
 		block_read(fs_device, sector, e->buffer);
 	}
 	memcpy(buffer, e->buffer, BLOCK_SECTOR_SIZE);
@@ -102,7 +135,8 @@ void buffer_cache_read(block_sector_t sector, void *buffer)
 	lock_release(&cache_lock);
 }
 
-void buffer_cache_write(block_sector_t sector, const void *buffer)
+static void buffer_cache_write_entry(block_sector_t sector, const void *buffer,
+	bool pin, block_sector_t owner)
 {
 	lock_acquire(&cache_lock);
 
@@ -111,6 +145,7 @@ void buffer_cache_write(block_sector_t sector, const void *buffer)
 		e = buffer_cache_select_victim();
 		e->valid = true;
 		e->dirty = false;
+		e->pinned = false;
 		e->sector = sector;
 		block_read(fs_device, sector, e->buffer);
 	}
@@ -118,6 +153,85 @@ void buffer_cache_write(block_sector_t sector, const void *buffer)
 	memcpy(e->buffer, buffer, BLOCK_SECTOR_SIZE);
 	e->reference = true;
 	e->dirty = true;
+	e->owner = owner;
+	if (pin)
+		e->pinned = true;
+
+	lock_release(&cache_lock);
+}
+
+void buffer_cache_write(block_sector_t sector, const void *buffer)
+{
+	buffer_cache_write_entry(sector, buffer, false, CACHE_NO_OWNER);
+}
+
+/* Like buffer_cache_write(), but records that SECTOR holds data
+   of the inode at sector OWNER, so buffer_cache_flush_owner() can
+   find it. */
+void buffer_cache_write_owned(block_sector_t sector, const void *buffer,
+	block_sector_t owner)
+{
+	buffer_cache_write_entry(sector, buffer, false, owner);
+}
+
+/* Like buffer_cache_write(), but keeps SECTOR in the cache until
+   buffer_cache_unpin() is called for it.  Used by the journal so
+   that a logged sector is never written in place before its
+   transaction has committed. */
+void buffer_cache_write_pinned(block_sector_t sector, const void *buffer)
+{
+	buffer_cache_write_entry(sector, buffer, true, CACHE_NO_OWNER);
+}
+
+/* Copies the contents of sector SRC to sector DST, which becomes
+   part of the data of the inode at sector OWNER, without going
+   through a caller's buffer.  DST is overwritten entirely, so it
+   is never read from disk. */
+void buffer_cache_copy(block_sector_t dst, block_sector_t src,
+	block_sector_t owner)
+{
+	lock_acquire(&cache_lock);
+
+	struct cache_entry *s = buffer_cache_lookup(src);
+	if (s == NULL) {
+		s = buffer_cache_select_victim();
+		s->valid = true;
+		s->dirty = false;
+		s->pinned = false;
+		s->sector = src;
+		s->owner = CACHE_NO_OWNER;
+		block_read(fs_device, src, s->buffer);
+	}
+	s->reference = true;
+
+	struct cache_entry *d = buffer_cache_lookup(dst);
+	if (d == NULL) {
+		/* Keep S from being chosen as the victim. */
+		bool was_pinned = s->pinned;
+		s->pinned = true;
+		d = buffer_cache_select_victim();
+		s->pinned = was_pinned;
+
+		d->valid = true;
+		d->pinned = false;
+		d->sector = dst;
+	}
+
+	memcpy(d->buffer, s->buffer, BLOCK_SECTOR_SIZE);
+	d->reference = true;
+	d->dirty = true;
+	d->owner = owner;
+
+	lock_release(&cache_lock);
+}
+
+void buffer_cache_unpin(block_sector_t sector)
+{
+	lock_acquire(&cache_lock);
+
+	struct cache_entry *e = buffer_cache_lookup(sector);
+	if (e != NULL)
+		e->pinned = false;
 
 	lock_release(&cache_lock);
 }
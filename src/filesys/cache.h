@@ -3,12 +3,23 @@
 
 #include "devices/block.h"
 
+/* Owner of cached sectors that do not belong to a file's data. */
+#define CACHE_NO_OWNER ((block_sector_t) -1)
+
 void buffer_cache_init(void);
 void buffer_cache_terminate(void);
+void buffer_cache_flush_all(void);
+void buffer_cache_flush_owner(block_sector_t owner);
 struct cache_entry* buffer_cache_select_victim(void);
 struct cache_entry* buffer_cache_lookup(block_sector_t sector);
 void buffer_cache_flush_entry(struct cache_entry *entry);
 void buffer_cache_read(block_sector_t sector, void *buffer);
 void buffer_cache_write(block_sector_t sector, const void *buffer);
+void buffer_cache_write_owned(block_sector_t sector, const void *buffer,
+	block_sector_t owner);
+void buffer_cache_write_pinned(block_sector_t sector, const void *buffer);
+void buffer_cache_unpin(block_sector_t sector);
+void buffer_cache_copy(block_sector_t dst, block_sector_t src,
+	block_sector_t owner);
 
 #endif
@@ -90,6 +90,23 @@ struct inode *
 	return dir->inode;
 }
 
+/* Each directory operation holds the directory inode's dir_lock
+   for its whole duration, so a lookup followed by an update is
+   atomic with respect to other operations on the same directory,
+   while operations on different directories proceed in parallel. */
+static void
+dir_lock(const struct dir *dir)
+{
+	lock_acquire(&dir->inode->dir_lock);
+}
+
+static void
+dir_unlock(const struct dir *dir)
+{
+	lock_release(&dir->inode->dir_lock);
+}
+
+/* Searches DIR, which must be locked, for NAME. */
 static bool
 lookup(const struct dir *dir, const char *name,
 	struct dir_entry *ep, off_t *ofsp)
@@ -122,6 +139,7 @@ dir_lookup(const struct dir *dir, const char *name,
 	ASSERT(dir != NULL);
 	ASSERT(name != NULL);
 
+	dir_lock(dir);
 	if (strcmp(name, ".") == 0) {
 		*inode = inode_reopen(dir->inode);
 	}
@@ -134,6 +152,7 @@ dir_lookup(const struct dir *dir, const char *name,
 	}
 	else
 		*inode = NULL;
+	dir_unlock(dir);
 
 	return *inode != NULL;
 }
@@ -143,6 +162,7 @@ dir_add(struct dir *dir, const char *name, block_sector_t inode_sector, bool is_
 {
 	struct dir_entry e;
 	off_t ofs;
+	bool success = false;
 
 	ASSERT(dir != NULL);
 	ASSERT(name != NULL);
@@ -151,24 +171,28 @@ dir_add(struct dir *dir, const char *name, block_sector_t inode_sector, bool is_
 	if (*name == '\0' || strlen(name) > NAME_MAX)
 		return false;
 
-	/* Check that NAME is not in use. */
-	if (lookup(dir, name, NULL, NULL))
-		return false;
+	dir_lock(dir);
+
+	/* Check that DIR still exists and NAME is not in use. */
+	if (dir->inode->removed || lookup(dir, name, NULL, NULL))
+		goto done;
 
 	if (is_dir == true)
 	{
+		/* The new directory is not reachable yet, so it needs no
+		   locking of its own. */
 		struct dir *new_directory = dir_open(inode_open(inode_sector));
 		if (new_directory == NULL)
-			return false;
+			goto done;
 		e.inode_sector = inode_get_inumber(dir_get_inode(dir));
 		if (inode_write_at(new_directory->inode, &e, sizeof e, 0) != sizeof e) {
 			dir_close(new_directory);
-			return false;
+			goto done;
 		}
 		dir_close(new_directory);
 	}
 
-	for (ofs = 0; inode_read_at(dir->inode, &e, sizeof e, ofs) == sizeof e;
+	for (ofs = sizeof e; inode_read_at(dir->inode, &e, sizeof e, ofs) == sizeof e;
 		ofs += sizeof e)
 		if (!e.in_use)
 			break;
@@ -177,7 +201,11 @@ dir_add(struct dir *dir, const char *name, block_sector_t inode_sector, bool is_
 	e.in_use = true;
 	strlcpy(e.name, name, sizeof e.name);
 	e.inode_sector = inode_sector;
-	return inode_write_at(dir->inode, &e, sizeof e, ofs) == sizeof e;
+	success = inode_write_at(dir->inode, &e, sizeof e, ofs) == sizeof e;
+
+done:
+	dir_unlock(dir);
+	return success;
 }
 
 bool
@@ -191,6 +219,7 @@ dir_remove(struct dir *dir, const char *name)
 	ASSERT(dir != NULL);
 	ASSERT(name != NULL);
 
+	dir_lock(dir);
 	if (!lookup(dir, name, &e, &ofs))
 		goto done;
 
@@ -199,29 +228,32 @@ dir_remove(struct dir *dir, const char *name)
 		goto done;
 
 	if (inode->data.is_dir) {
-		struct dir *d = dir_open(inode);
-
-		struct dir_entry e;
-		off_t ofs;
-
-		for(ofs = sizeof e; inode_read_at(d->inode, &e, sizeof e, ofs) == sizeof e;
-				ofs += sizeof e){
-			if(e.in_use == true){
-				dir_close(d);
+		/* Hold the child's lock too, so nothing can be added to it
+		   between the emptiness check and marking it removed. */
+		struct dir_entry child;
+		off_t child_ofs;
+
+		lock_acquire(&inode->dir_lock);
+		for(child_ofs = sizeof child;
+				inode_read_at(inode, &child, sizeof child, child_ofs) == sizeof child;
+				child_ofs += sizeof child){
+			if(child.in_use == true){
+				lock_release(&inode->dir_lock);
 				goto done;
 			}
 		}
-		dir_close(d);
 	}
 
 	e.in_use = false;
-	if (inode_write_at(dir->inode, &e, sizeof e, ofs) != sizeof e)
-		goto done;
-
-	inode_remove(inode);
-	success = true;
+	if (inode_write_at(dir->inode, &e, sizeof e, ofs) == sizeof e) {
+		inode_remove(inode);
+		success = true;
+	}
+	if (inode->data.is_dir)
+		lock_release(&inode->dir_lock);
 
 done:
+	dir_unlock(dir);
 	inode_close(inode);
 	return success;
 }
@@ -230,17 +262,21 @@ bool
 dir_readdir(struct dir *dir, char name[NAME_MAX + 1])
 {
 	struct dir_entry e;
+	bool found = false;
 
+	dir_lock(dir);
 	while (inode_read_at(dir->inode, &e, sizeof e, dir->pos) == sizeof e)
 	{
 		dir->pos += sizeof e;
 		if (e.in_use)
 		{
 			strlcpy(name, e.name, NAME_MAX + 1);
-			return true;
+			found = true;
+			break;
 		}
 	}
-	return false;
+	dir_unlock(dir);
+	return found;
 }
 
 void extract_directory_filename_from_path(const char *path, char *directory, char *filename)
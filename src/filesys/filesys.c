@@ -8,6 +8,7 @@
 #include "filesys/free-map.h"
 #include "filesys/inode.h"
 #include "filesys/directory.h"
+#include "filesys/journal.h"
 
 struct block *fs_device;
 
@@ -28,6 +29,7 @@ filesys_init(bool format)
 	if (format)
 		do_format();
 
+	journal_init();
 	free_map_open();
 }
 
@@ -36,6 +38,7 @@ filesys_done(void)
 {
 	free_map_close();
 
+	journal_done();
 	buffer_cache_terminate();
 }
 
@@ -49,13 +52,29 @@ filesys_create(const char *path, off_t initial_size, bool is_dir)
 	extract_directory_filename_from_path(path, d, f);
 	struct dir *dir = dir_open_from_path(d);
 
+	journal_begin();
 	bool success = (dir != NULL
 		&& free_map_allocate(1, &inode_sector)
-		&& inode_create(inode_sector, initial_size, is_dir)
+		&& inode_create(inode_sector, 0, is_dir)
 		&& dir_add(dir, f, inode_sector, is_dir));
 
 	if (!success && inode_sector != 0)
 		free_map_release(inode_sector, 1);
+	journal_end();
+
+	/* Allocate the initial size afterward, in pieces small enough
+	   for the journal. */
+	if (success && initial_size > 0) {
+		struct inode *inode = inode_open(inode_sector);
+
+		success = inode != NULL && inode_extend(inode, initial_size);
+		if (!success) {
+			journal_begin();
+			dir_remove(dir, f);
+			journal_end();
+		}
+		inode_close(inode);
+	}
 	dir_close(dir);
 
 	return success;
@@ -105,20 +124,32 @@ filesys_remove(const char *name)
 		dir_close(dir);
 		return false;
 	}
+	journal_begin();
 	if(!dir_remove(dir,f)){
+		journal_end();
 		dir_close(dir);
 		return false;
 	}
+	journal_end();
 
 	dir_close(dir);
 	return true;
 }
 
+/* Writes all dirty cached sectors back to disk. */
+void
+filesys_sync(void)
+{
+	journal_sync();
+	buffer_cache_flush_all();
+}
+
 /* Formats the file system. */
 static void
 do_format(void)
 {
 	printf("Formatting file system...");
+	journal_format();
 	free_map_create();
 	if (!dir_create(ROOT_DIR_SECTOR, 16))
 		PANIC("root directory creation failed");
@@ -15,5 +15,6 @@ bool filesys_create(const char *name, off_t initial_size, bool is_dir);
 struct file *filesys_open(const char *name);
 bool filesys_remove(const char *name);
 bool filesys_chdir(const char *dir_path);
+void filesys_sync(void);
 
 #endif /* filesys/filesys.h */
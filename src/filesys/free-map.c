@@ -4,19 +4,24 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
+#include "filesys/journal.h"
+#include "threads/synch.h"
 
 static struct file *free_map_file;   /* Free map file. */
 static struct bitmap *free_map;      /* Free map, one bit per sector. */
+static struct lock free_map_lock;    /* Protects free_map and its file. */
 
 /* Initializes the free map. */
 void
 free_map_init(void)
 {
+	lock_init(&free_map_lock);
 	free_map = bitmap_create(block_size(fs_device));
 	if (free_map == NULL)
 		PANIC("bitmap creation failed--file system device is too large");
 	bitmap_mark(free_map, FREE_MAP_SECTOR);
 	bitmap_mark(free_map, ROOT_DIR_SECTOR);
+	bitmap_set_multiple(free_map, JOURNAL_SECTOR, JOURNAL_SIZE, true);
 }
 
 /* Allocates CNT consecutive sectors from the free map and stores
@@ -27,14 +32,18 @@ free_map_init(void)
 bool
 free_map_allocate(size_t cnt, block_sector_t *sectorp)
 {
-	block_sector_t sector = bitmap_scan_and_flip(free_map, 0, cnt, false);
+	block_sector_t sector;
+
+	lock_acquire(&free_map_lock);
+	sector = bitmap_scan_and_flip(free_map, 0, cnt, false);
 	if (sector != BITMAP_ERROR
 		&& free_map_file != NULL
-		&& !bitmap_write(free_map, free_map_file))
+		&& !bitmap_write_range(free_map, free_map_file, sector, cnt))
 	{
 		bitmap_set_multiple(free_map, sector, cnt, false);
 		sector = BITMAP_ERROR;
 	}
+	lock_release(&free_map_lock);
 	if (sector != BITMAP_ERROR)
 		*sectorp = sector;
 	return sector != BITMAP_ERROR;
@@ -44,9 +53,11 @@ free_map_allocate(size_t cnt, block_sector_t *sectorp)
 void
 free_map_release(block_sector_t sector, size_t cnt)
 {
+	lock_acquire(&free_map_lock);
 	ASSERT(bitmap_all(free_map, sector, cnt));
 	bitmap_set_multiple(free_map, sector, cnt, false);
-	bitmap_write(free_map, free_map_file);
+	bitmap_write_range(free_map, free_map_file, sector, cnt);
+	lock_release(&free_map_lock);
 }
 
 /* Opens the free map file and reads it from disk. */
@@ -1,5 +1,6 @@
 #include "filesys/fsutil.h"
 #include <debug.h>
+#include <round.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -175,8 +176,9 @@ fsutil_append(char **argv)
 
 	printf("Appending '%s' to ustar archive on scratch device...\n", file_name);
 
-	/* Allocate buffer. */
-	buffer = malloc(BLOCK_SECTOR_SIZE);
+	/* Allocate buffer.  The source is read a page at a time so
+	   that the file system can fetch several sectors per call. */
+	buffer = palloc_get_page(0);
 	if (buffer == NULL)
 		PANIC("couldn't allocate buffer");
 
@@ -199,13 +201,15 @@ fsutil_append(char **argv)
 	/* Do copy. */
 	while (size > 0)
 	{
-		int chunk_size = size > BLOCK_SECTOR_SIZE ? BLOCK_SECTOR_SIZE : size;
-		if (sector >= block_size(dst))
+		int chunk_size = size > PGSIZE ? PGSIZE : size;
+		int ofs;
+		if (sector + DIV_ROUND_UP(chunk_size, BLOCK_SECTOR_SIZE) > block_size(dst))
 			PANIC("%s: out of space on scratch device", file_name);
 		if (file_read(src, buffer, chunk_size) != chunk_size)
 			PANIC("%s: read failed with %"PROTd" bytes unread", file_name, size);
-		memset(buffer + chunk_size, 0, BLOCK_SECTOR_SIZE - chunk_size);
-		block_write(dst, sector++, buffer);
+		memset(buffer + chunk_size, 0, ROUND_UP(chunk_size, BLOCK_SECTOR_SIZE) - chunk_size);
+		for (ofs = 0; ofs < chunk_size; ofs += BLOCK_SECTOR_SIZE)
+			block_write(dst, sector++, buffer + ofs);
 		size -= chunk_size;
 	}
 
@@ -218,5 +222,5 @@ fsutil_append(char **argv)
 
 	/* Finish up. */
 	file_close(src);
-	free(buffer);
+	palloc_free_page(buffer);
 }
@@ -6,6 +6,7 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "filesys/cache.h"
+#include "filesys/journal.h"
 #include "threads/malloc.h"
 
 /* Identifies an inode. */
@@ -32,12 +33,46 @@ byte_to_sector(const struct inode *inode, off_t pos)
 		return -1;
 }
 
+/* Returns true if INODE's contents are file system metadata,
+   whose updates must go through the journal. */
+static bool
+inode_is_metadata(const struct inode *inode)
+{
+	return inode->data.is_dir || inode->sector == FREE_MAP_SECTOR;
+}
+
+/* Writes BUFFER to SECTOR, one of INODE's data sectors. */
+static void
+write_data_sector(struct inode *inode, block_sector_t sector, const void *buffer)
+{
+	if (inode_is_metadata(inode))
+		journal_write(sector, buffer);
+	else
+		buffer_cache_write_owned(sector, buffer, inode->sector);
+}
+
+/* Locking.
+
+   open_inodes_lock protects the list of open inodes and every
+   inode's open_cnt, so that opening a sector twice always yields
+   the same struct inode.  Each inode's lock serializes growing
+   it and changes to deny_write_cnt; reads and in-place writes do
+   not take it, since the sectors below the current length never
+   change and the length is only raised after the new sectors are
+   in place.  Directories additionally have dir_lock, taken by
+   directory.c around each lookup, add, remove or readdir.
+
+   Locks are always acquired in the order: a directory's dir_lock,
+   then its children's, then an inode lock, then the free map,
+   journal and buffer cache locks. */
 static struct list open_inodes;
+static struct lock open_inodes_lock;
 
 void
 inode_init(void)
 {
 	list_init(&open_inodes);
+	lock_init(&open_inodes_lock);
 }
 
 bool
@@ -58,7 +93,7 @@ inode_create(block_sector_t sector, off_t length, bool is_dir)
 		disk_inode->is_dir = is_dir;
 		if (alloc_inode(disk_inode,disk_inode->length))
 		{
-			buffer_cache_write(sector, disk_inode);
+			journal_write(sector, disk_inode);
 			success = true;
 		}
 		free(disk_inode);
@@ -72,28 +107,36 @@ struct inode *
 	struct list_elem *e;
 	struct inode *inode;
 
+	lock_acquire(&open_inodes_lock);
 	for (e = list_begin(&open_inodes); e != list_end(&open_inodes);
 		e = list_next(e))
 	{
 		inode = list_entry(e, struct inode, elem);
 		if (inode->sector == sector)
 		{
-			inode_reopen(inode);
+			inode->open_cnt++;
+			lock_release(&open_inodes_lock);
 			return inode;
 		}
 	}
 
 	inode = malloc(sizeof *inode);
-	if (inode == NULL)
+	if (inode == NULL) {
+		lock_release(&open_inodes_lock);
 		return NULL;
+	}
 
 	list_push_front(&open_inodes, &inode->elem);
 	inode->sector = sector;
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
+	inode->exec_cnt = 0;
 	inode->removed = false;
+	lock_init(&inode->lock);
+	lock_init(&inode->dir_lock);
 
 	buffer_cache_read(inode->sector, &inode->data);
+	lock_release(&open_inodes_lock);
 	return inode;
 }
 
@@ -101,8 +144,11 @@ struct inode *
 struct inode *
 	inode_reopen(struct inode *inode)
 {
-	if (inode != NULL)
+	if (inode != NULL) {
+		lock_acquire(&open_inodes_lock);
 		inode->open_cnt++;
+		lock_release(&open_inodes_lock);
+	}
 	return inode;
 }
 
@@ -116,17 +162,25 @@ inode_get_inumber(const struct inode *inode)
 void
 inode_close(struct inode *inode)
 {
+	bool last;
+
 	if (inode == NULL)
 		return;
 
-	if (--inode->open_cnt == 0)
-	{
+	lock_acquire(&open_inodes_lock);
+	last = --inode->open_cnt == 0;
+	if (last)
 		list_remove(&inode->elem);
+	lock_release(&open_inodes_lock);
 
+	if (last)
+	{
 		if (inode->removed)
 		{
+			journal_begin();
 			free_map_release(inode->sector, 1);
 			dealloc_inode(inode);
+			journal_end();
 		}
 
 		free(inode);
@@ -140,13 +194,137 @@ inode_remove(struct inode *inode)
 	inode->removed = true;
 }
 
+/* Position within an array of struct iovec. */
+struct iov_cursor
+{
+	const struct iovec *iov;            /* Current buffer. */
+	int cnt;                            /* Buffers left, including current. */
+	size_t ofs;                         /* Offset within current buffer. */
+};
+
+static void
+iov_cursor_init(struct iov_cursor *c, const struct iovec *iov, int cnt)
+{
+	c->iov = iov;
+	c->cnt = cnt;
+	c->ofs = 0;
+	while (c->cnt > 0 && c->iov->iov_len == 0) {
+		c->iov++;
+		c->cnt--;
+	}
+}
+
+/* Returns the total length of the CNT buffers in IOV. */
+static off_t
+iov_length(const struct iovec *iov, int cnt)
+{
+	off_t size = 0;
+	for (int i = 0; i < cnt; i++)
+		size += iov[i].iov_len;
+	return size;
+}
+
+/* Returns the address of the next SIZE bytes at C if they all lie
+   in a single buffer, otherwise a null pointer. */
+static uint8_t *
+iov_contiguous(const struct iov_cursor *c, size_t size)
+{
+	if (c->cnt > 0 && c->iov->iov_len - c->ofs >= size)
+		return (uint8_t *) c->iov->iov_base + c->ofs;
+	return NULL;
+}
+
+/* Copies SIZE bytes between C and BUF, in the direction given by
+   TO_IOV, and advances C past them. */
+static void
+iov_copy(struct iov_cursor *c, uint8_t *buf, size_t size, bool to_iov)
+{
+	while (size > 0) {
+		ASSERT(c->cnt > 0);
+
+		size_t left = c->iov->iov_len - c->ofs;
+		size_t n = size < left ? size : left;
+		uint8_t *p = (uint8_t *) c->iov->iov_base + c->ofs;
+
+		if (buf != NULL) {
+			if (to_iov)
+				memcpy(p, buf, n);
+			else
+				memcpy(buf, p, n);
+			buf += n;
+		}
+		size -= n;
+		c->ofs += n;
+		while (c->cnt > 0 && c->ofs == c->iov->iov_len) {
+			c->iov++;
+			c->cnt--;
+			c->ofs = 0;
+		}
+	}
+}
+
+/* Most bytes a file grows by in one journal operation.  Growing
+   by this much logs at most the inode, the doubly indirect block,
+   two indirect blocks and the free map sectors that the new
+   sectors' bits fall in. */
+#define EXTEND_STEP (128 * BLOCK_SECTOR_SIZE)
+
+/* Grows INODE, if necessary, so that it is at least LENGTH bytes
+   long.  Large extensions are made in EXTEND_STEP pieces, each a
+   journal operation of its own, so that none outgrows its log
+   reservation.  Returns false if the sectors could not be
+   allocated. */
+bool
+inode_extend(struct inode *inode, off_t length)
+{
+	bool success = true;
+
+	if (byte_to_sector(inode, length - 1) != -1)
+		return true;
+
+	lock_acquire(&inode->lock);
+	while (success && byte_to_sector(inode, length - 1) == -1) {
+		off_t step = length - inode->data.length > EXTEND_STEP
+			? inode->data.length + EXTEND_STEP : length;
+
+		journal_begin();
+		success = alloc_inode(&inode->data, step);
+		if (success) {
+			/* Concurrent readers look only below the length, so
+			   publish it after the new sectors are in place. */
+			barrier();
+			inode->data.length = step;
+			journal_write(inode->sector, &inode->data);
+		}
+		journal_end();
+	}
+	lock_release(&inode->lock);
+	return success;
+}
+
+off_t
+inode_read_at(struct inode *inode, void *buffer, off_t size, off_t offset)
+{
+	struct iovec iov;
+
+	iov.iov_base = buffer;
+	iov.iov_len = size;
+	return inode_readv_at(inode, &iov, 1, offset);
+}
+
+/* Reads into the CNT buffers of IOV, in order, from INODE starting
+   at OFFSET.  Returns the number of bytes actually read, which may
+   be less than their total length if end of file is reached. */
 off_t
-inode_read_at(struct inode *inode, void *buffer_, off_t size, off_t offset)
+inode_readv_at(struct inode *inode, const struct iovec *iov, int cnt,
+	off_t offset)
 {
-	uint8_t *buffer = buffer_;
+	struct iov_cursor c;
+	off_t size = iov_length(iov, cnt);
 	off_t bytes_read = 0;
 	uint8_t *bounce = NULL;
 
+	iov_cursor_init(&c, iov, cnt);
 	while (size > 0)
 	{
 		/* Disk sector to read, starting byte offset within sector. */
@@ -160,18 +338,20 @@ inode_read_at(struct inode *inode, void *buffer_, off_t size, off_t offset)
 
 		/* Number of bytes to actually copy out of this sector. */
 		int chunk_size = size < min_left ? size : min_left;
+		uint8_t *dst = iov_contiguous(&c, chunk_size);
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE)
+		if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE && dst != NULL)
 		{
 			/* Read full sector directly into caller's buffer. */
-			buffer_cache_read(sector_idx, buffer + bytes_read);
+			buffer_cache_read(sector_idx, dst);
+			iov_copy(&c, NULL, chunk_size, true);
 		}
 		else
 		{
 			/* Read sector into bounce buffer, then partially copy
-			   into caller's buffer. */
+			   into caller's buffers. */
 			if (bounce == NULL)
 			{
 				bounce = malloc(BLOCK_SECTOR_SIZE);
@@ -179,7 +359,7 @@ inode_read_at(struct inode *inode, void *buffer_, off_t size, off_t offset)
 					break;
 			}
 			buffer_cache_read(sector_idx, bounce);
-			memcpy(buffer + bytes_read, bounce + sector_ofs, chunk_size);
+			iov_copy(&c, bounce + sector_ofs, chunk_size, true);
 		}
 
 		/* Advance. */
@@ -193,24 +373,35 @@ inode_read_at(struct inode *inode, void *buffer_, off_t size, off_t offset)
 }
 
 off_t
-inode_write_at(struct inode *inode, const void *buffer_, off_t size,
+inode_write_at(struct inode *inode, const void *buffer, off_t size,
+	off_t offset)
+{
+	struct iovec iov;
+
+	iov.iov_base = (void *) buffer;
+	iov.iov_len = size;
+	return inode_writev_at(inode, &iov, 1, offset);
+}
+
+/* Writes the CNT buffers of IOV, in order, to INODE starting at
+   OFFSET, growing it first if necessary.  Returns the number of
+   bytes actually written. */
+off_t
+inode_writev_at(struct inode *inode, const struct iovec *iov, int cnt,
 	off_t offset)
 {
-	const uint8_t *buffer = buffer_;
+	struct iov_cursor c;
+	off_t size = iov_length(iov, cnt);
 	off_t bytes_written = 0;
 	uint8_t *bounce = NULL;
 
 	if (inode->deny_write_cnt)
 		return 0;
 
-	if (byte_to_sector(inode, offset + size - 1) == -1) {
-		if(!alloc_inode(&inode->data, offset + size)){
-			return 0;
-		}
-		inode->data.length = offset + size;
-		buffer_cache_write(inode->sector, &inode->data);
-	}
+	if (size > 0 && !inode_extend(inode, offset + size))
+		return 0;
 
+	iov_cursor_init(&c, iov, cnt);
 	while (size > 0)
 	{
 		/* Sector to write, starting byte offset within sector. */
@@ -224,13 +415,15 @@ inode_write_at(struct inode *inode, const void *buffer_, off_t size,
 
 		/* Number of bytes to actually write into this sector. */
 		int chunk_size = size < min_left ? size : min_left;
+		uint8_t *src = iov_contiguous(&c, chunk_size);
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE)
+		if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE && src != NULL)
 		{
 			/* Write full sector directly to disk. */
-			buffer_cache_write(sector_idx, buffer + bytes_written);
+			write_data_sector(inode, sector_idx, src);
+			iov_copy(&c, NULL, chunk_size, false);
 		}
 		else
 		{
@@ -249,8 +442,8 @@ inode_write_at(struct inode *inode, const void *buffer_, off_t size,
 				buffer_cache_read(sector_idx, bounce);
 			else
 				memset(bounce, 0, BLOCK_SECTOR_SIZE);
-			memcpy(bounce + sector_ofs, buffer + bytes_written, chunk_size);
-			buffer_cache_write(sector_idx, bounce);
+			iov_copy(&c, bounce + sector_ofs, chunk_size, false);
+			write_data_sector(inode, sector_idx, bounce);
 		}
 
 		/* Advance. */
@@ -263,13 +456,89 @@ inode_write_at(struct inode *inode, const void *buffer_, off_t size,
 	return bytes_written;
 }
 
+/* Copies up to SIZE bytes of SRC starting at SRC_OFS into DST
+   starting at DST_OFS, growing DST for the whole range up front.
+   Sectors that line up on both sides are copied directly between
+   buffer cache entries; only unaligned pieces go through a bounce
+   buffer.  Returns the number of bytes copied, which is less than
+   SIZE if end of SRC is reached.  Overlapping ranges of the same
+   inode are not supported and copy nothing. */
+off_t
+inode_copy_at(struct inode *dst, off_t dst_ofs, struct inode *src,
+	off_t src_ofs, off_t size)
+{
+	off_t bytes_copied = 0;
+	uint8_t *bounce = NULL;
+
+	if (dst->deny_write_cnt || inode_is_metadata(dst) || inode_dir(src))
+		return 0;
+
+	if (src_ofs >= inode_length(src))
+		return 0;
+	if (size > inode_length(src) - src_ofs)
+		size = inode_length(src) - src_ofs;
+	if (size <= 0)
+		return 0;
+
+	if (src == dst && src_ofs < dst_ofs + size && dst_ofs < src_ofs + size)
+		return 0;
+
+	if (!inode_extend(dst, dst_ofs + size))
+		return 0;
+
+	while (size > 0)
+	{
+		int src_sector_ofs = src_ofs % BLOCK_SECTOR_SIZE;
+		int dst_sector_ofs = dst_ofs % BLOCK_SECTOR_SIZE;
+		int chunk_size;
+
+		if (src_sector_ofs == 0 && dst_sector_ofs == 0
+			&& size >= BLOCK_SECTOR_SIZE)
+		{
+			chunk_size = BLOCK_SECTOR_SIZE;
+			buffer_cache_copy(byte_to_sector(dst, dst_ofs),
+				byte_to_sector(src, src_ofs), dst->sector);
+		}
+		else
+		{
+			/* Copy up to the next sector boundary on either side. */
+			int src_left = BLOCK_SECTOR_SIZE - src_sector_ofs;
+			int dst_left = BLOCK_SECTOR_SIZE - dst_sector_ofs;
+			chunk_size = src_left < dst_left ? src_left : dst_left;
+			if (size < chunk_size)
+				chunk_size = size;
+
+			if (bounce == NULL)
+			{
+				bounce = malloc(BLOCK_SECTOR_SIZE);
+				if (bounce == NULL)
+					break;
+			}
+			if (inode_read_at(src, bounce, chunk_size, src_ofs) != chunk_size
+				|| inode_write_at(dst, bounce, chunk_size, dst_ofs) != chunk_size)
+				break;
+		}
+
+		/* Advance. */
+		size -= chunk_size;
+		src_ofs += chunk_size;
+		dst_ofs += chunk_size;
+		bytes_copied += chunk_size;
+	}
+	free(bounce);
+
+	return bytes_copied;
+}
+
 /* Disables writes to INODE.
    May be called at most once per inode opener. */
 void
 inode_deny_write(struct inode *inode)
 {
+	lock_acquire(&inode->lock);
 	inode->deny_write_cnt++;
 	ASSERT(inode->deny_write_cnt <= inode->open_cnt);
+	lock_release(&inode->lock);
 }
 
 /* Re-enables writes to INODE.
@@ -278,9 +547,52 @@ inode_deny_write(struct inode *inode)
 void
 inode_allow_write(struct inode *inode)
 {
+	lock_acquire(&inode->lock);
 	ASSERT(inode->deny_write_cnt > 0);
 	ASSERT(inode->deny_write_cnt <= inode->open_cnt);
 	inode->deny_write_cnt--;
+	lock_release(&inode->lock);
+}
+
+/* Records that a process is running INODE as its executable,
+   which denies writes to it until inode_exec_end().  The caller
+   must keep INODE open for that long. */
+void
+inode_exec_begin(struct inode *inode)
+{
+	lock_acquire(&inode->lock);
+	inode->exec_cnt++;
+	inode->deny_write_cnt++;
+	ASSERT(inode->deny_write_cnt <= inode->open_cnt);
+	lock_release(&inode->lock);
+}
+
+/* Records that a process running INODE has exited. */
+void
+inode_exec_end(struct inode *inode)
+{
+	lock_acquire(&inode->lock);
+	ASSERT(inode->exec_cnt > 0);
+	ASSERT(inode->deny_write_cnt > 0);
+	inode->exec_cnt--;
+	inode->deny_write_cnt--;
+	lock_release(&inode->lock);
+}
+
+/* Returns true if some process is running INODE. */
+bool
+inode_is_exec(const struct inode *inode)
+{
+	return inode->exec_cnt > 0;
+}
+
+/* Makes INODE durable: waits for its metadata to commit to the
+   journal, then writes back its dirty data sectors. */
+void
+inode_flush(struct inode *inode)
+{
+	journal_sync();
+	buffer_cache_flush_owner(inode->sector);
 }
 
 /* Returns the length, in bytes, of INODE's data. */
@@ -302,10 +614,13 @@ bool allocate_block(block_sector_t* block){
 	return true;
 }
 
+/* Indirect blocks are logged only if they change, so that growing
+   a large file logs only the blocks around its end. */
 bool
 alloc_inode_doubly_indirect(block_sector_t* block, size_t size)
 {
 	struct indirect_block indirect_block;
+	bool changed = false;
 	if (*block == 0) {
 		free_map_allocate(1, block);
 		buffer_cache_write(*block, empty_page);
@@ -316,12 +631,15 @@ alloc_inode_doubly_indirect(block_sector_t* block, size_t size)
 
 	for (size_t i = 0; i < l; i++) {
 		size_t alloc_length = size < INDIRECT ? size : INDIRECT;
+		if (indirect_block.pointers[i] == 0)
+			changed = true;
 		if (!alloc_inode_indirect(&indirect_block.pointers[i], alloc_length))
 			return false;
 		size -= alloc_length;
 	}
 
-	buffer_cache_write(*block, &indirect_block);
+	if (changed)
+		journal_write(*block, &indirect_block);
 	return true;
 }
 
@@ -329,6 +647,7 @@ bool
 alloc_inode_indirect(block_sector_t* block, size_t size)
 {
 	struct indirect_block indirect_block;
+	bool changed = false;
 	if (*block == 0) {
 		free_map_allocate(1, block);
 		buffer_cache_write(*block, empty_page);
@@ -336,10 +655,13 @@ alloc_inode_indirect(block_sector_t* block, size_t size)
 	buffer_cache_read(*block, &indirect_block);
 
 	for(size_t i=0; i<size; i++){
+		if(indirect_block.pointers[i] == 0)
+			changed = true;
 		if(!allocate_block(&indirect_block.pointers[i]))
 				return false;
 	}
-	buffer_cache_write(*block, &indirect_block);
+	if(changed)
+		journal_write(*block, &indirect_block);
 	return true;
 }
 
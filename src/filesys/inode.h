@@ -5,6 +5,8 @@
 #include "filesys/off_t.h"
 #include "devices/block.h"
 #include <list.h>
+#include <iovec.h>
+#include "threads/synch.h"
 
 /* In-memory inode. */
 /* On-disk inode.
@@ -26,6 +28,9 @@ struct inode
 	int open_cnt;                       /* Number of openers. */
 	bool removed;                       /* True if deleted, false otherwise. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+	int exec_cnt;                       /* Processes running this file. */
+	struct lock lock;                   /* Protects growth and the counts. */
+	struct lock dir_lock;               /* Serializes directory operations. */
 	struct inode_disk data;             /* Inode content. */
 };
 
@@ -40,9 +45,20 @@ void inode_close(struct inode *);
 void inode_remove(struct inode *);
 off_t inode_read_at(struct inode *, void *, off_t size, off_t offset);
 off_t inode_write_at(struct inode *, const void *, off_t size, off_t offset);
+off_t inode_readv_at(struct inode *, const struct iovec *, int cnt,
+	off_t offset);
+off_t inode_writev_at(struct inode *, const struct iovec *, int cnt,
+	off_t offset);
+off_t inode_copy_at(struct inode *dst, off_t dst_ofs, struct inode *src,
+	off_t src_ofs, off_t size);
 void inode_deny_write(struct inode *);
 void inode_allow_write(struct inode *);
+void inode_exec_begin(struct inode *);
+void inode_exec_end(struct inode *);
+bool inode_is_exec(const struct inode *);
 off_t inode_length(const struct inode *);
+bool inode_extend(struct inode *, off_t length);
+void inode_flush(struct inode *);
 
 block_sector_t get_sector_number(const struct inode_disk *, off_t);
 bool allocate_block(block_sector_t*);
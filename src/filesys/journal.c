@@ -0,0 +1,338 @@
+#include "filesys/journal.h"
+#include <debug.h>
+#include <stdint.h>
+#include <string.h>
+#include "filesys/cache.h"
+#include "filesys/filesys.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Write-ahead journal for file system metadata.
+
+   Inode sectors, indirect blocks, directory contents and the free
+   map are written with journal_write() instead of going straight
+   to the buffer cache.  Each logged sector stays pinned in the
+   cache until the transaction it belongs to has been copied to
+   the log, so nothing reaches its home location before it is
+   recoverable.
+
+   Operations bracket their updates with journal_begin() and
+   journal_end().  The transaction is committed only when the last
+   outstanding operation ends, so metadata updates from concurrent
+   operations are batched into one sequential log write (group
+   commit), and a commit never contains half of an operation.
+   Each operation reserves room for OP_MAX sectors in the open
+   transaction when it begins; operations that would not fit wait
+   for the next transaction.  After a commit the home copies are
+   simply left dirty in the cache; they are checkpointed all at
+   once when the log region runs out of room or at shutdown.
+
+   On disk the log is a sequence of transactions starting right
+   after the superblock, each laid out as
+
+        descriptor | logged sectors... | commit
+
+   where the commit block is a copy of the descriptor with a
+   different magic number.  The superblock records the sequence
+   number of the first transaction that has not been checkpointed
+   yet; recovery replays consecutive transactions from there until
+   it finds one without a matching commit block. */
+
+#define SUPER_MAGIC 0x4a4e4c53          /* Superblock. */
+#define DESC_MAGIC 0x4a4e4c44           /* Transaction descriptor. */
+#define COMMIT_MAGIC 0x4a4e4c43         /* Transaction commit. */
+
+/* Maximum number of sectors in one transaction.  These are all
+   pinned in the buffer cache, so this must stay well below its
+   capacity. */
+#define TXN_MAX 32
+
+/* Most distinct sectors one operation may log.  Operations are
+   kept under this by the file system: a file grows at most
+   EXTEND_STEP bytes per operation (see inode.c), and the free map
+   of a device up to 24 MB spans at most 6 sectors. */
+#define OP_MAX 10
+
+#define LOG_START (JOURNAL_SECTOR + 1)
+#define LOG_END (JOURNAL_SECTOR + JOURNAL_SIZE)
+
+/* On-disk superblock.
+   Must be exactly BLOCK_SECTOR_SIZE bytes long. */
+struct journal_super
+{
+	unsigned magic;
+	uint32_t seq;                       /* First transaction to replay. */
+	uint8_t unused[BLOCK_SECTOR_SIZE - 8];
+};
+
+/* On-disk transaction descriptor and commit block.
+   Must be exactly BLOCK_SECTOR_SIZE bytes long. */
+struct journal_desc
+{
+	unsigned magic;
+	uint32_t seq;                       /* Transaction sequence number. */
+	uint32_t cnt;                       /* Number of logged sectors. */
+	block_sector_t sectors[TXN_MAX];    /* Home location of each one. */
+	uint8_t unused[BLOCK_SECTOR_SIZE - 12 - TXN_MAX * sizeof(block_sector_t)];
+};
+
+static struct lock journal_lock;
+static struct condition commit_cond;    /* Signaled after each commit. */
+static bool journal_active;             /* False while formatting. */
+
+static int outstanding;                 /* Operations in progress. */
+static bool committing;                 /* Commit I/O in progress. */
+static uint32_t seq;                    /* Sequence number of open transaction. */
+static block_sector_t log_head;         /* Where it will be written. */
+static block_sector_t txn[TXN_MAX];     /* Sectors it has logged so far. */
+static size_t txn_cnt;
+
+/* Scratch sectors, used by the committing thread or with
+   journal_lock held.  Kept off the kernel stack, which is only a
+   few kB. */
+static struct journal_super super;
+static struct journal_desc desc;
+static struct journal_desc commit_block;
+static uint8_t block[BLOCK_SECTOR_SIZE];
+
+static void commit(void);
+static void checkpoint(void);
+static void end_locked(void);
+
+/* Writes an empty journal to a freshly formatted device. */
+void
+journal_format(void)
+{
+	ASSERT(sizeof super == BLOCK_SECTOR_SIZE);
+	ASSERT(sizeof desc == BLOCK_SECTOR_SIZE);
+
+	memset(&super, 0, sizeof super);
+	super.magic = SUPER_MAGIC;
+	super.seq = 1;
+	block_write(fs_device, JOURNAL_SECTOR, &super);
+}
+
+/* Replays any transactions that committed before the last
+   shutdown but were never checkpointed, then starts logging. */
+void
+journal_init(void)
+{
+	block_sector_t pos = LOG_START;
+
+	lock_init(&journal_lock);
+	cond_init(&commit_cond);
+
+	block_read(fs_device, JOURNAL_SECTOR, &super);
+	if (super.magic != SUPER_MAGIC)
+		PANIC("no journal found on file system device, reformat it");
+
+	seq = super.seq;
+	while (pos + 2 <= LOG_END)
+	{
+		block_read(fs_device, pos, &desc);
+		if (desc.magic != DESC_MAGIC || desc.seq != seq
+			|| desc.cnt > TXN_MAX || pos + desc.cnt + 2 > LOG_END)
+			break;
+
+		block_read(fs_device, pos + desc.cnt + 1, &commit_block);
+		if (commit_block.magic != COMMIT_MAGIC || commit_block.seq != seq
+			|| commit_block.cnt != desc.cnt)
+			break;
+
+		for (size_t i = 0; i < desc.cnt; i++) {
+			block_read(fs_device, pos + i + 1, block);
+			buffer_cache_write(desc.sectors[i], block);
+		}
+		pos += desc.cnt + 2;
+		seq++;
+	}
+
+	checkpoint();
+	journal_active = true;
+}
+
+/* Commits whatever is still open and checkpoints the log, so the
+   next boot has nothing to replay. */
+void
+journal_done(void)
+{
+	lock_acquire(&journal_lock);
+	while (committing || outstanding > 0)
+		cond_wait(&commit_cond, &journal_lock);
+	journal_active = false;
+	lock_release(&journal_lock);
+
+	checkpoint();
+}
+
+/* Starts an operation whose metadata updates must reach the disk
+   together.  Calls may nest; a nested call joins the operation
+   already in progress in the calling thread.  Waits while a
+   commit is in progress or the open transaction has no room left
+   for another operation. */
+void
+journal_begin(void)
+{
+	struct thread *t = thread_current();
+
+	if (!journal_active)
+		return;
+	if (t->journal_depth++ > 0)
+		return;
+
+	lock_acquire(&journal_lock);
+	while (committing
+		|| txn_cnt + (outstanding + 1) * OP_MAX > TXN_MAX)
+		cond_wait(&commit_cond, &journal_lock);
+	outstanding++;
+	lock_release(&journal_lock);
+}
+
+/* Ends an operation started with journal_begin().  The last one
+   to finish commits the transaction on behalf of all of them. */
+void
+journal_end(void)
+{
+	struct thread *t = thread_current();
+
+	if (!journal_active)
+		return;
+	ASSERT(t->journal_depth > 0);
+	if (--t->journal_depth > 0)
+		return;
+
+	lock_acquire(&journal_lock);
+	end_locked();
+	lock_release(&journal_lock);
+}
+
+/* Ends the calling thread's operation.  If it was the last one
+   outstanding, commits the open transaction, with journal_lock
+   released during the disk writes.  New operations wait for the
+   commit to finish, so nothing changes the transaction or its
+   sectors meanwhile. */
+static void
+end_locked(void)
+{
+	ASSERT(lock_held_by_current_thread(&journal_lock));
+	ASSERT(outstanding > 0);
+
+	if (--outstanding == 0) {
+		committing = true;
+		lock_release(&journal_lock);
+		commit();
+		lock_acquire(&journal_lock);
+		committing = false;
+	}
+	/* Wake operations waiting for room or for the commit. */
+	cond_broadcast(&commit_cond, &journal_lock);
+}
+
+/* Waits until every metadata update made so far is committed.
+   Must not be called from inside an operation. */
+void
+journal_sync(void)
+{
+	uint32_t target;
+
+	if (!journal_active)
+		return;
+
+	lock_acquire(&journal_lock);
+	target = seq;
+	while ((txn_cnt > 0 || committing) && seq == target)
+		cond_wait(&commit_cond, &journal_lock);
+	lock_release(&journal_lock);
+}
+
+/* Writes metadata BUFFER to SECTOR as part of the calling
+   thread's operation.  A write outside any operation is an
+   operation of its own.  Repeated writes to the same sector
+   within a transaction are absorbed into one log entry. */
+void
+journal_write(block_sector_t sector, const void *buffer)
+{
+	size_t i;
+
+	if (!journal_active) {
+		buffer_cache_write(sector, buffer);
+		return;
+	}
+	if (thread_current()->journal_depth == 0) {
+		journal_begin();
+		journal_write(sector, buffer);
+		journal_end();
+		return;
+	}
+
+	lock_acquire(&journal_lock);
+
+	for (i = 0; i < txn_cnt; i++)
+		if (txn[i] == sector)
+			break;
+
+	if (i == txn_cnt) {
+		/* Reservations keep this from happening, unless an
+		   operation logs more than OP_MAX sectors. */
+		if (txn_cnt == TXN_MAX)
+			PANIC("journal: operation logs more than %d sectors", OP_MAX);
+		txn[txn_cnt++] = sector;
+	}
+	buffer_cache_write_pinned(sector, buffer);
+
+	lock_release(&journal_lock);
+}
+
+/* Copies the open transaction to the log with one sequential
+   write and releases its sectors to ordinary write-back.  Called
+   with no operation outstanding and either committing set or the
+   journal inactive, so that journal_lock is not needed. */
+static void
+commit(void)
+{
+	if (txn_cnt == 0)
+		return;
+
+	memset(&desc, 0, sizeof desc);
+	desc.magic = DESC_MAGIC;
+	desc.seq = seq;
+	desc.cnt = txn_cnt;
+	memcpy(desc.sectors, txn, txn_cnt * sizeof *txn);
+
+	block_write(fs_device, log_head, &desc);
+	for (size_t i = 0; i < txn_cnt; i++) {
+		buffer_cache_read(txn[i], block);
+		block_write(fs_device, log_head + i + 1, block);
+	}
+	desc.magic = COMMIT_MAGIC;
+	block_write(fs_device, log_head + txn_cnt + 1, &desc);
+
+	for (size_t i = 0; i < txn_cnt; i++)
+		buffer_cache_unpin(txn[i]);
+
+	log_head += txn_cnt + 2;
+	seq++;
+	txn_cnt = 0;
+
+	/* Make sure the next transaction will always fit. */
+	if (log_head + TXN_MAX + 2 > LOG_END)
+		checkpoint();
+}
+
+/* Writes every committed sector to its home location and empties
+   the log.  Must be called with no transaction open, under the
+   same conditions as commit(). */
+static void
+checkpoint(void)
+{
+	ASSERT(txn_cnt == 0);
+
+	buffer_cache_flush_all();
+
+	memset(&super, 0, sizeof super);
+	super.magic = SUPER_MAGIC;
+	super.seq = seq;
+	block_write(fs_device, JOURNAL_SECTOR, &super);
+
+	log_head = LOG_START;
+}
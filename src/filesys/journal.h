@@ -0,0 +1,20 @@
+#ifndef FILESYS_JOURNAL_H
+#define FILESYS_JOURNAL_H
+
+#include "devices/block.h"
+
+/* Sectors reserved for the metadata journal: a superblock at
+   JOURNAL_SECTOR followed by the log itself. */
+#define JOURNAL_SECTOR 2
+#define JOURNAL_SIZE 128
+
+void journal_format(void);
+void journal_init(void);
+void journal_done(void);
+
+void journal_begin(void);
+void journal_end(void);
+void journal_write(block_sector_t sector, const void *buffer);
+void journal_sync(void);
+
+#endif /* filesys/journal.h */
@@ -1,14 +1,19 @@
 #include <console.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include "devices/serial.h"
 #include "devices/vga.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 
 static void vprintf_helper (char, void *);
 static void putchar_have_lock (uint8_t c);
+static void klog_flush_have_lock (void);
+static void acquire_console (void);
+static void release_console (void);
 
 /* The console lock.
    Both the vga and serial layers do their own locking, so it's
@@ -59,6 +64,30 @@ static int console_lock_depth;
 /* Number of characters written to console. */
 static int64_t write_cnt;
 
+/* Kernel log.
+
+   klog_printf() formats its message into an in-memory ring and
+   returns without touching the serial port or the display, so
+   that busy paths such as process exit never wait on the UART.
+   A low-priority thread copies new log text to the console when
+   the CPU is otherwise idle.
+
+   Every direct console write first flushes whatever the log
+   still holds, so log messages and ordinary output appear in the
+   order they were produced.  The ring also keeps the most recent
+   KLOG_SIZE bytes after they have been printed, for klog_read().
+
+   klog_head and klog_tail count bytes ever appended and ever
+   printed, respectively; byte N lives at klog_buf[N % KLOG_SIZE].
+   Both change only with interrupts off. */
+#define KLOG_SIZE 4096
+#define KLOG_LINE_MAX 128               /* Longest single message. */
+static char klog_buf[KLOG_SIZE];
+static uint32_t klog_head;
+static uint32_t klog_tail;
+static struct semaphore klog_sema;      /* Upped when text is appended. */
+static bool klog_started;
+
 /* Enable console locking. */
 void
 console_init (void) 
@@ -67,6 +96,84 @@ console_init (void)
   use_console_lock = true;
 }
 
+static void klog_thread (void *);
+
+/* Starts the thread that drains the kernel log.  Until then, log
+   text is printed by the next console write. */
+void
+klog_init (void) 
+{
+  sema_init (&klog_sema, 0);
+  klog_started = true;
+  thread_create ("klog", PRI_MIN, klog_thread, NULL);
+}
+
+/* Appends a message to the kernel log without waiting for it to
+   be printed.  Messages longer than KLOG_LINE_MAX bytes are
+   truncated.  May be called from an interrupt handler. */
+int
+klog_printf (const char *format, ...) 
+{
+  char line[KLOG_LINE_MAX];
+  enum intr_level old_level;
+  va_list args;
+  int len, i;
+
+  va_start (args, format);
+  len = vsnprintf (line, sizeof line, format, args);
+  va_end (args);
+  if (len > (int) sizeof line - 1)
+    len = sizeof line - 1;
+
+  /* Check for room and append in one critical section, so that
+     another producer, such as an interrupt handler, cannot take
+     the room in between. */
+  for (;;) 
+    {
+      old_level = intr_disable ();
+      if (klog_head - klog_tail + len <= KLOG_SIZE)
+        break;
+      intr_set_level (old_level);
+
+      /* The ring is full of text nobody has printed yet.  That
+         only happens if the log thread has been starved for a
+         long time, so print it here rather than lose it. */
+      acquire_console ();
+      klog_flush_have_lock ();
+      release_console ();
+    }
+  for (i = 0; i < len; i++)
+    klog_buf[klog_head++ % KLOG_SIZE] = line[i];
+  intr_set_level (old_level);
+
+  if (klog_started)
+    sema_up (&klog_sema);
+  return len;
+}
+
+/* Copies the most recent text in the kernel log, up to SIZE
+   bytes of it, into BUFFER.  Returns the number of bytes
+   copied. */
+size_t
+klog_read (char *buffer, size_t size) 
+{
+  enum intr_level old_level;
+  uint32_t start;
+  size_t i;
+
+  old_level = intr_disable ();
+  if (size > KLOG_SIZE)
+    size = KLOG_SIZE;
+  if (size > klog_head)
+    size = klog_head;
+  start = klog_head - size;
+  for (i = 0; i < size; i++)
+    buffer[i] = klog_buf[(start + i) % KLOG_SIZE];
+  intr_set_level (old_level);
+
+  return size;
+}
+
 /* Notifies the console that a kernel panic is underway,
    which warns it to avoid trying to take the console lock from
    now on. */
@@ -83,7 +190,9 @@ console_print_stats (void)
   printf ("Console: %lld characters output\n", write_cnt);
 }
 
-/* Acquires the console lock. */
+/* Acquires the console lock, then prints any pending kernel log
+   text so that it comes out ahead of whatever the caller is about
+   to write. */
 static void
 acquire_console (void) 
 {
@@ -94,6 +203,7 @@ acquire_console (void)
       else
         lock_acquire (&console_lock); 
     }
+  klog_flush_have_lock ();
 }
 
 /* Releases the console lock. */
@@ -148,13 +258,17 @@ puts (const char *s)
   return 0;
 }
 
-/* Writes the N characters in BUFFER to the console. */
+/* Writes the N characters in BUFFER to the console.  The serial
+   port gets them all at once.  BUFFER must be kernel memory: see
+   serial_putbuf(). */
 void
 putbuf (const char *buffer, size_t n) 
 {
   acquire_console ();
+  write_cnt += n;
+  serial_putbuf (buffer, n);
   while (n-- > 0)
-    putchar_have_lock (*buffer++);
+    vga_putc (*buffer++);
   release_console ();
 }
 
@@ -169,6 +283,44 @@ putchar (int c)
   return c;
 }
 
+/* Prints kernel log text that has not been printed yet.
+   The caller has already acquired the console lock if
+   appropriate. */
+static void
+klog_flush_have_lock (void) 
+{
+  for (;;) 
+    {
+      enum intr_level old_level = intr_disable ();
+      char c;
+
+      if (klog_tail == klog_head) 
+        {
+          intr_set_level (old_level);
+          break;
+        }
+      c = klog_buf[klog_tail++ % KLOG_SIZE];
+      intr_set_level (old_level);
+
+      putchar_have_lock (c);
+    }
+}
+
+/* Prints the kernel log as it fills.  Runs at the lowest
+   priority, so it only competes with the idle thread. */
+static void
+klog_thread (void *aux UNUSED) 
+{
+  for (;;) 
+    {
+      sema_down (&klog_sema);
+
+      /* Taking the console prints the log. */
+      acquire_console ();
+      release_console ();
+    }
+}
+
 /* Helper function for vprintf(). */
 static void
 vprintf_helper (char c, void *char_cnt_) 
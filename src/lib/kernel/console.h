@@ -1,8 +1,15 @@
 #ifndef __LIB_KERNEL_CONSOLE_H
 #define __LIB_KERNEL_CONSOLE_H
 
+#include <debug.h>
+#include <stddef.h>
+
 void console_init (void);
 void console_panic (void);
 void console_print_stats (void);
 
+void klog_init (void);
+int klog_printf (const char *, ...) PRINTF_FORMAT (1, 2);
+size_t klog_read (char *, size_t);
+
 #endif /* lib/kernel/console.h */
@@ -0,0 +1,87 @@
+#ifndef __LIB_RING_H
+#define __LIB_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Submission and completion rings for batching system calls.
+
+   The process places a struct ring anywhere in its own memory,
+   queues requests on the submission ring with ring_get_sqe(), and
+   hands the whole batch to the kernel with one ring_enter() call.
+   The kernel consumes submissions in order and posts one
+   completion for each, carrying the request's user_data and its
+   result as the corresponding system call would have returned it.
+
+   Indexes run freely and are reduced modulo RING_ENTRIES when used.
+   The process owns sq_tail and cq_head; the kernel owns sq_head
+   and cq_tail. */
+
+/* Number of entries in each ring.  Must be a power of 2. */
+#define RING_ENTRIES 64
+
+/* Request operations. */
+enum ring_op
+  {
+    RING_OP_NOP,                /* Does nothing, completes with 0. */
+    RING_OP_READ,               /* read (fd, buf, len). */
+    RING_OP_WRITE,              /* write (fd, buf, len). */
+    RING_OP_OPEN,               /* open (buf). */
+    RING_OP_CLOSE               /* close (fd), completes with 0. */
+  };
+
+/* Submission queue entry. */
+struct ring_sqe
+  {
+    uint32_t op;                /* One of RING_OP_*. */
+    int32_t fd;                 /* File descriptor. */
+    void *buf;                  /* Buffer, or file name for open. */
+    uint32_t len;               /* Buffer length in bytes. */
+    uint32_t user_data;         /* Copied to the completion. */
+  };
+
+/* Completion queue entry. */
+struct ring_cqe
+  {
+    uint32_t user_data;         /* From the submission. */
+    int32_t res;                /* Result of the operation. */
+  };
+
+struct ring
+  {
+    uint32_t sq_head;           /* Next submission the kernel takes. */
+    uint32_t sq_tail;           /* Next free submission slot. */
+    uint32_t cq_head;           /* Next completion to reap. */
+    uint32_t cq_tail;           /* Next completion the kernel posts. */
+    struct ring_sqe sqes[RING_ENTRIES];
+    struct ring_cqe cqes[RING_ENTRIES];
+  };
+
+/* Returns the next free submission entry of R and queues it,
+   or a null pointer if the submission ring is full. */
+static inline struct ring_sqe *
+ring_get_sqe (struct ring *r)
+{
+  if (r->sq_tail - r->sq_head >= RING_ENTRIES)
+    return NULL;
+  return &r->sqes[r->sq_tail++ % RING_ENTRIES];
+}
+
+/* Returns the oldest unreaped completion of R, or a null pointer
+   if there is none. */
+static inline struct ring_cqe *
+ring_peek_cqe (struct ring *r)
+{
+  if (r->cq_head == r->cq_tail)
+    return NULL;
+  return &r->cqes[r->cq_head % RING_ENTRIES];
+}
+
+/* Marks the completion returned by ring_peek_cqe() as reaped. */
+static inline void
+ring_cqe_seen (struct ring *r)
+{
+  r->cq_head++;
+}
+
+#endif /* lib/ring.h */
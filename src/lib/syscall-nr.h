@@ -32,7 +32,23 @@ enum
 
     /* additional system call */
     SYS_FIBONACCI,
-    SYS_MAXOFFOURINT
+    SYS_MAXOFFOURINT,
+
+    /* File system extensions. */
+    SYS_FSYNC,                  /* Write a file's dirty data to disk. */
+    SYS_SYNC,                   /* Write all dirty data to disk. */
+    SYS_PREAD,                  /* Read from a file at an offset. */
+    SYS_PWRITE,                 /* Write to a file at an offset. */
+    SYS_READV,                  /* Read from a file into several buffers. */
+    SYS_WRITEV,                 /* Write several buffers to a file. */
+    SYS_COPY_FILE_RANGE,        /* Copy between files inside the kernel. */
+
+    /* Batched system calls. */
+    SYS_RING_ENTER,             /* Process queued ring submissions. */
+
+    /* Instrumentation. */
+    SYS_SYSCALL_STATS,          /* Fetch and reset system call statistics. */
+    SYS_DMESG                   /* Read the kernel log. */
   };
 
 #endif /* lib/syscall-nr.h */
@@ -0,0 +1,19 @@
+#ifndef __LIB_SYSCALL_STATS_H
+#define __LIB_SYSCALL_STATS_H
+
+#include <stdint.h>
+
+/* Number of latency histogram buckets.  Bucket I counts calls
+   that took between 2**I and 2**(I+1) - 1 CPU cycles; the last
+   bucket also takes everything slower. */
+#define SYSCALL_STATS_BUCKETS 32
+
+/* Statistics for one system call number. */
+struct syscall_stats
+  {
+    uint64_t cnt;                       /* Completed calls. */
+    uint64_t cycles;                    /* Total CPU cycles spent. */
+    uint32_t hist[SYSCALL_STATS_BUCKETS]; /* Latency histogram. */
+  };
+
+#endif /* lib/syscall-stats.h */
@@ -210,3 +210,63 @@ max_of_four_int(int a,int b,int c, int d)
 {
   return syscall4 (SYS_MAXOFFOURINT, a, b, c, d);
 }
+
+int
+fsync (int fd)
+{
+  return syscall1 (SYS_FSYNC, fd);
+}
+
+void
+sync (void)
+{
+  syscall0 (SYS_SYNC);
+}
+
+int
+pread (int fd, void *buffer, unsigned size, unsigned offset)
+{
+  return syscall4 (SYS_PREAD, fd, buffer, size, offset);
+}
+
+int
+pwrite (int fd, const void *buffer, unsigned size, unsigned offset)
+{
+  return syscall4 (SYS_PWRITE, fd, buffer, size, offset);
+}
+
+int
+readv (int fd, const struct iovec *iov, int iovcnt)
+{
+  return syscall3 (SYS_READV, fd, iov, iovcnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iovcnt)
+{
+  return syscall3 (SYS_WRITEV, fd, iov, iovcnt);
+}
+
+int
+copy_file_range (int fd_in, int fd_out, unsigned length)
+{
+  return syscall3 (SYS_COPY_FILE_RANGE, fd_in, fd_out, length);
+}
+
+int
+ring_enter (struct ring *ring)
+{
+  return syscall1 (SYS_RING_ENTER, ring);
+}
+
+int
+get_syscall_stats (struct syscall_stats *stats, unsigned cnt, bool reset)
+{
+  return syscall3 (SYS_SYSCALL_STATS, stats, cnt, (int) reset);
+}
+
+int
+dmesg (char *buffer, unsigned size)
+{
+  return syscall2 (SYS_DMESG, buffer, size);
+}
@@ -3,6 +3,9 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <iovec.h>
+#include <ring.h>
+#include <syscall-stats.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -48,4 +51,20 @@ int inumber (int fd);
 int fibonacci(int n);
 int max_of_four_int(int a,int b,int c,int d);
 
+/* File system extensions. */
+int fsync (int fd);
+void sync (void);
+int pread (int fd, void *buffer, unsigned length, unsigned offset);
+int pwrite (int fd, const void *buffer, unsigned length, unsigned offset);
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+int copy_file_range (int fd_in, int fd_out, unsigned length);
+
+/* Batched system calls. */
+int ring_enter (struct ring *);
+
+/* Instrumentation. */
+int get_syscall_stats (struct syscall_stats *, unsigned cnt, bool reset);
+int dmesg (char *, unsigned size);
+
 #endif /* lib/user/syscall.h */
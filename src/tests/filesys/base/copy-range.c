@@ -0,0 +1,52 @@
+/* Copies a file with copy_file_range(), first from the start at
+   sector-aligned positions and then from an unaligned offset,
+   and verifies the data and both file positions. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE 5000
+#define SKIP 123
+
+static char buf[FILE_SIZE];
+static char readback[FILE_SIZE];
+
+void
+test_main (void) 
+{
+  int src_fd, dst_fd;
+
+  random_bytes (buf, sizeof buf);
+  CHECK (create ("src", 0), "create \"src\"");
+  CHECK ((src_fd = open ("src")) > 1, "open \"src\"");
+  CHECK (write (src_fd, buf, sizeof buf) == FILE_SIZE, "write \"src\"");
+
+  CHECK (create ("dst", 0), "create \"dst\"");
+  CHECK ((dst_fd = open ("dst")) > 1, "open \"dst\"");
+
+  seek (src_fd, 0);
+  CHECK (copy_file_range (src_fd, dst_fd, FILE_SIZE * 2) == FILE_SIZE,
+         "copy \"src\" to \"dst\"");
+  CHECK (tell (src_fd) == FILE_SIZE && tell (dst_fd) == FILE_SIZE,
+         "both positions advanced");
+  CHECK (pread (dst_fd, readback, FILE_SIZE, 0) == FILE_SIZE,
+         "pread \"dst\"");
+  compare_bytes (readback, buf, FILE_SIZE, 0, "dst");
+
+  seek (src_fd, SKIP);
+  seek (dst_fd, 0);
+  CHECK (copy_file_range (src_fd, dst_fd, FILE_SIZE - SKIP)
+         == FILE_SIZE - SKIP, "copy \"src\" to \"dst\" from offset %d", SKIP);
+  CHECK (pread (dst_fd, readback, FILE_SIZE - SKIP, 0) == FILE_SIZE - SKIP,
+         "pread \"dst\"");
+  compare_bytes (readback, buf + SKIP, FILE_SIZE - SKIP, SKIP, "dst");
+
+  CHECK (copy_file_range (src_fd, src_fd, 1) == -1,
+         "copy \"src\" onto itself fails");
+  msg ("close \"src\"");
+  close (src_fd);
+  msg ("close \"dst\"");
+  close (dst_fd);
+}
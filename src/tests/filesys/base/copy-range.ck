@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(copy-range) begin
+(copy-range) create "src"
+(copy-range) open "src"
+(copy-range) write "src"
+(copy-range) create "dst"
+(copy-range) open "dst"
+(copy-range) copy "src" to "dst"
+(copy-range) both positions advanced
+(copy-range) pread "dst"
+(copy-range) copy "src" to "dst" from offset 123
+(copy-range) pread "dst"
+(copy-range) copy "src" onto itself fails
+(copy-range) close "src"
+(copy-range) close "dst"
+(copy-range) end
+EOF
+pass;
@@ -0,0 +1,32 @@
+/* Writes a file, flushes it with fsync(), and verifies that the
+   data reads back after closing and reopening the file.  Then
+   checks that fsync() rejects a descriptor that is no longer
+   open and flushes the whole file system with sync(). */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[5678];
+
+void
+test_main (void) 
+{
+  const char *file_name = "durable";
+  int fd;
+
+  CHECK (create (file_name, 0), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  random_bytes (buf, sizeof buf);
+  CHECK (write (fd, buf, sizeof buf) == sizeof buf,
+         "write \"%s\"", file_name);
+  CHECK (fsync (fd) == 0, "fsync \"%s\"", file_name);
+  msg ("close \"%s\"", file_name);
+  close (fd);
+  check_file (file_name, buf, sizeof buf);
+  CHECK (fsync (fd) == -1, "fsync closed fd");
+  msg ("sync");
+  sync ();
+  check_file (file_name, buf, sizeof buf);
+}
@@ -0,0 +1,55 @@
+/* Writes and reads a file in shuffled blocks with pwrite() and
+   pread(), and verifies that neither moves the file position. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define BLOCK_SIZE 517
+#define BLOCK_CNT 12
+
+static char buf[BLOCK_SIZE * BLOCK_CNT];
+static char readback[BLOCK_SIZE * BLOCK_CNT];
+static size_t order[BLOCK_CNT];
+
+void
+test_main (void) 
+{
+  const char *file_name = "positional";
+  size_t i;
+  int fd;
+
+  CHECK (create (file_name, 0), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  random_bytes (buf, sizeof buf);
+  for (i = 0; i < BLOCK_CNT; i++)
+    order[i] = i;
+
+  shuffle (order, BLOCK_CNT, sizeof *order);
+  msg ("pwrite \"%s\" in random order", file_name);
+  for (i = 0; i < BLOCK_CNT; i++)
+    {
+      size_t ofs = order[i] * BLOCK_SIZE;
+      if (pwrite (fd, buf + ofs, BLOCK_SIZE, ofs) != BLOCK_SIZE)
+        fail ("pwrite of %d bytes at offset %zu failed",
+              BLOCK_SIZE, ofs);
+    }
+
+  shuffle (order, BLOCK_CNT, sizeof *order);
+  msg ("pread \"%s\" in random order", file_name);
+  for (i = 0; i < BLOCK_CNT; i++)
+    {
+      size_t ofs = order[i] * BLOCK_SIZE;
+      if (pread (fd, readback + ofs, BLOCK_SIZE, ofs) != BLOCK_SIZE)
+        fail ("pread of %d bytes at offset %zu failed",
+              BLOCK_SIZE, ofs);
+    }
+  compare_bytes (readback, buf, sizeof buf, 0, file_name);
+
+  CHECK (tell (fd) == 0, "tell \"%s\" is still 0", file_name);
+  CHECK (pread (fd, readback, BLOCK_SIZE, sizeof buf) == 0,
+         "pread past end of \"%s\"", file_name);
+  msg ("close \"%s\"", file_name);
+  close (fd);
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(pread) begin
+(pread) create "positional"
+(pread) open "positional"
+(pread) pwrite "positional" in random order
+(pread) pread "positional" in random order
+(pread) tell "positional" is still 0
+(pread) pread past end of "positional"
+(pread) close "positional"
+(pread) end
+EOF
+pass;
@@ -0,0 +1,59 @@
+/* Writes a record made of a header, a payload and a trailer with
+   one writev(), then reads it back with one readv() into buffers
+   split at different points. */
+
+#include <random.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char header[37];
+static char payload[1300];
+static char trailer[211];
+
+static char record[sizeof header + sizeof payload + sizeof trailer];
+static char readback[sizeof record];
+
+void
+test_main (void) 
+{
+  const char *file_name = "vectored";
+  struct iovec out[3], in[4];
+  int fd;
+
+  random_bytes (header, sizeof header);
+  random_bytes (payload, sizeof payload);
+  random_bytes (trailer, sizeof trailer);
+  memcpy (record, header, sizeof header);
+  memcpy (record + sizeof header, payload, sizeof payload);
+  memcpy (record + sizeof header + sizeof payload, trailer, sizeof trailer);
+
+  out[0].iov_base = header;
+  out[0].iov_len = sizeof header;
+  out[1].iov_base = payload;
+  out[1].iov_len = sizeof payload;
+  out[2].iov_base = trailer;
+  out[2].iov_len = sizeof trailer;
+
+  in[0].iov_base = readback;
+  in[0].iov_len = 512;
+  in[1].iov_base = readback + 512;
+  in[1].iov_len = 0;
+  in[2].iov_base = readback + 512;
+  in[2].iov_len = 700;
+  in[3].iov_base = readback + 1212;
+  in[3].iov_len = sizeof readback - 1212;
+
+  CHECK (create (file_name, 0), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  CHECK (writev (fd, out, 3) == sizeof record, "writev \"%s\"", file_name);
+  CHECK (tell (fd) == sizeof record, "tell \"%s\" after writev", file_name);
+  msg ("seek \"%s\" to 0", file_name);
+  seek (fd, 0);
+  CHECK (readv (fd, in, 4) == sizeof record, "readv \"%s\"", file_name);
+  compare_bytes (readback, record, sizeof record, 0, file_name);
+  CHECK (readv (fd, in, 4) == 0, "readv at end of \"%s\"", file_name);
+  msg ("close \"%s\"", file_name);
+  close (fd);
+}
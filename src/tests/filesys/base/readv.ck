@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(readv) begin
+(readv) create "vectored"
+(readv) open "vectored"
+(readv) writev "vectored"
+(readv) tell "vectored" after writev
+(readv) seek "vectored" to 0
+(readv) readv "vectored"
+(readv) readv at end of "vectored"
+(readv) close "vectored"
+(readv) end
+EOF
+pass;
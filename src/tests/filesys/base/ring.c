@@ -0,0 +1,95 @@
+/* Opens, writes and closes a file through the submission ring,
+   queueing all the writes and the close in one batch, then reads
+   the file back through the ring and verifies it. */
+
+#include <random.h>
+#include <ring.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHUNK_SIZE 100
+#define CHUNK_CNT 20
+
+static char buf[CHUNK_SIZE * CHUNK_CNT];
+static char readback[CHUNK_SIZE * CHUNK_CNT];
+static struct ring ring;
+
+/* Queues a request on the ring. */
+static void
+queue (enum ring_op op, int fd, void *buffer, unsigned len, unsigned tag)
+{
+  struct ring_sqe *sqe = ring_get_sqe (&ring);
+  if (sqe == NULL)
+    fail ("submission ring full");
+  sqe->op = op;
+  sqe->fd = fd;
+  sqe->buf = buffer;
+  sqe->len = len;
+  sqe->user_data = tag;
+}
+
+/* Reaps the next completion, checking its tag, and returns its
+   result. */
+static int
+reap (unsigned tag)
+{
+  struct ring_cqe *cqe = ring_peek_cqe (&ring);
+  int res;
+
+  if (cqe == NULL)
+    fail ("no completion for request %u", tag);
+  if (cqe->user_data != tag)
+    fail ("completion for request %u, expected %u", cqe->user_data, tag);
+  res = cqe->res;
+  ring_cqe_seen (&ring);
+  return res;
+}
+
+/* Opens FILE_NAME through the ring. */
+static int
+ring_open (const char *file_name)
+{
+  int fd;
+
+  queue (RING_OP_OPEN, 0, (void *) file_name, 0, 0);
+  CHECK (ring_enter (&ring) == 1, "ring open \"%s\"", file_name);
+  CHECK ((fd = reap (0)) > 1, "got fd for \"%s\"", file_name);
+  return fd;
+}
+
+/* Queues CHUNK_CNT transfers of the file at FD and a close, and
+   submits them all at once. */
+static void
+ring_transfer (enum ring_op op, int fd, char *data, const char *what)
+{
+  size_t i;
+
+  for (i = 0; i < CHUNK_CNT; i++)
+    queue (op, fd, data + i * CHUNK_SIZE, CHUNK_SIZE, i + 1);
+  queue (RING_OP_CLOSE, fd, NULL, 0, CHUNK_CNT + 1);
+
+  CHECK (ring_enter (&ring) == CHUNK_CNT + 1,
+         "%s %d chunks and close in one batch", what, CHUNK_CNT);
+  for (i = 0; i < CHUNK_CNT; i++)
+    if (reap (i + 1) != CHUNK_SIZE)
+      fail ("%s of chunk %zu failed", what, i);
+  CHECK (reap (CHUNK_CNT + 1) == 0, "close completed");
+}
+
+void
+test_main (void) 
+{
+  const char *file_name = "batched";
+  int fd;
+
+  random_bytes (buf, sizeof buf);
+  CHECK (create (file_name, 0), "create \"%s\"", file_name);
+
+  fd = ring_open (file_name);
+  ring_transfer (RING_OP_WRITE, fd, buf, "write");
+
+  fd = ring_open (file_name);
+  ring_transfer (RING_OP_READ, fd, readback, "read");
+  compare_bytes (readback, buf, sizeof buf, 0, file_name);
+}
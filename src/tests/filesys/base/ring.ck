@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(ring) begin
+(ring) create "batched"
+(ring) ring open "batched"
+(ring) got fd for "batched"
+(ring) write 20 chunks and close in one batch
+(ring) close completed
+(ring) ring open "batched"
+(ring) got fd for "batched"
+(ring) read 20 chunks and close in one batch
+(ring) close completed
+(ring) end
+EOF
+pass;
@@ -0,0 +1,23 @@
+/* Runs a child process and checks that its exit message can be
+   read back from the kernel log. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char log[4096];
+
+void
+test_main (void) 
+{
+  int n;
+
+  CHECK (wait (exec ("child-simple")) == 81, "wait for child-simple");
+  n = dmesg (log, sizeof log - 1);
+  CHECK (n > 0, "read kernel log");
+  log[n] = '\0';
+  if (strstr (log, "child-simple: exit(81)\n") == NULL)
+    fail ("child's exit message missing from kernel log");
+  msg ("found child's exit message");
+}
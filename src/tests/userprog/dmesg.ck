@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(dmesg) begin
+(child-simple) run
+child-simple: exit(81)
+(dmesg) wait for child-simple
+(dmesg) read kernel log
+(dmesg) found child's exit message
+(dmesg) end
+dmesg: exit(0)
+EOF
+pass;
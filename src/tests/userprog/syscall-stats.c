@@ -0,0 +1,35 @@
+/* Resets the system call statistics, makes a known number of
+   filesize calls, and checks that they were counted and timed. */
+
+#include <syscall.h>
+#include <syscall-nr.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CALL_CNT 10
+#define STATS_CNT (SYS_SYSCALL_STATS + 1)
+
+static struct syscall_stats stats[STATS_CNT];
+
+void
+test_main (void) 
+{
+  uint64_t hist_cnt = 0;
+  int i;
+
+  CHECK (get_syscall_stats (stats, STATS_CNT, true) == STATS_CNT,
+         "reset statistics");
+  for (i = 0; i < CALL_CNT; i++)
+    filesize (-1);
+  CHECK (get_syscall_stats (stats, STATS_CNT, false) == STATS_CNT,
+         "fetch statistics");
+
+  for (i = 0; i < SYSCALL_STATS_BUCKETS; i++)
+    hist_cnt += stats[SYS_FILESIZE].hist[i];
+  if (stats[SYS_FILESIZE].cnt != CALL_CNT || hist_cnt != CALL_CNT)
+    fail ("%d filesize calls, but %d counted and %d in histogram",
+          CALL_CNT, (int) stats[SYS_FILESIZE].cnt, (int) hist_cnt);
+  if (stats[SYS_SYSCALL_STATS].cnt != 1)
+    fail ("first fetch not counted");
+  msg ("filesize counted %d times", CALL_CNT);
+}
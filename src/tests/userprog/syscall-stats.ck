@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(syscall-stats) begin
+(syscall-stats) reset statistics
+(syscall-stats) fetch statistics
+(syscall-stats) filesize counted 10 times
+(syscall-stats) end
+syscall-stats: exit(0)
+EOF
+pass;
@@ -13,6 +13,7 @@
 #include "devices/serial.h"
 #include "devices/shutdown.h"
 #include "devices/timer.h"
+#include "devices/tty.h"
 #include "devices/vga.h"
 #include "devices/rtc.h"
 #include "threads/interrupt.h"
@@ -37,6 +38,10 @@
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
 #endif
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/swap.h"
+#endif
 
 /* Page directory with kernel mappings only. */
 uint32_t *init_page_dir;
@@ -99,7 +104,7 @@ main (void)
   malloc_init ();
   paging_init ();
 #ifdef VM
-  init_frame_list();
+  frame_init();
 #endif
   /* Segmentation. */
 #ifdef USERPROG
@@ -112,6 +117,7 @@ main (void)
   timer_init ();
   kbd_init ();
   input_init ();
+  tty_init ();
 #ifdef USERPROG
   exception_init ();
   syscall_init ();
@@ -120,6 +126,7 @@ main (void)
   /* Start thread scheduler and enable interrupts. */
   thread_start ();
   serial_init_queue ();
+  klog_init ();
   timer_calibrate ();
 
 #ifdef FILESYS
@@ -130,6 +137,7 @@ main (void)
 #endif
 #ifdef VM
   init_swap_bitmap();
+  pageout_init();
 #endif
 
   printf ("Boot complete.\n");
@@ -148,6 +148,22 @@ palloc_free_page (void *page)
   palloc_free_multiple (page, 1);
 }
 
+/* Returns the number of pages in the user pool. */
+size_t
+palloc_user_page_cnt (void) 
+{
+  return bitmap_size (user_pool.used_map);
+}
+
+/* Returns the position of PAGE, which must have been obtained
+   with PAL_USER, within the user pool. */
+size_t
+palloc_user_page_idx (const void *page) 
+{
+  ASSERT (page_from_pool (&user_pool, (void *) page));
+  return pg_no (page) - pg_no (user_pool.base);
+}
+
 /* Initializes pool P as starting at START and ending at END,
    naming it NAME for debugging purposes. */
 static void
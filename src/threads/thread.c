@@ -14,6 +14,7 @@
 #ifdef USERPROG
 #include "userprog/process.h"
 #endif
+#include "userprog/syscall.h"
 #include "devices/timer.h"
 #ifdef VM
 #include "vm/frame.h"
@@ -107,7 +108,6 @@ thread_init (void)
   list_init (&ready_list);
   list_init (&all_list);
   list_init (&blocked_list);
-  //init_frame_list();
   load_avg = 0;
 
   /* Set up a thread structure for the running thread. */
@@ -544,8 +544,13 @@ init_thread (struct thread *t, const char *name, int priority)
   list_push_back(&(t->parent_list),&(running_thread()->parent_elem));
   t->create_success = true;
 /*add in proj2 */
-  list_init(&(t->file_list));
-  t->file_bitmap = NULL;
+  t->fd_table = NULL;
+  t->fd_cap = 0;
+  t->fd_free = FD_MIN;
+#ifdef VM
+  list_init (&t->mmap_list);
+  list_init (&t->pinned_list);
+#endif
 
 /*add in proj3 */
   t->nice = running_thread()->nice;
@@ -667,20 +672,6 @@ allocate_tid (void)
    Used by switch.S, which can't figure it out on its own. */
 uint32_t thread_stack_ofs = offsetof (struct thread, stack);
 
-bool
-thread_findname_foreach (const char* name)
-{
-  struct list_elem *e;
-
-  for (e = list_begin (&all_list); e != list_end (&all_list);
-       e = list_next (e))
-    {
-      struct thread *t = list_entry (e, struct thread, allelem);
-      if(!strcmp(t->name,name))
-	      return true;
-    }
-  return false;
-}
 void thread_block_with_time(int64_t ticks)
 {
   struct thread* cur = thread_current();
@@ -830,9 +821,3 @@ void calculate_priority()
   if(old_priority > thread_current()->priority)
 	  intr_yield_on_return();
 }
-void destroy_file_bitmap()
-{
-	if(thread_current()->file_bitmap != NULL){
-		bitmap_destroy(thread_current()->file_bitmap);
-	}
-}
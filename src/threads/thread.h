@@ -111,6 +111,8 @@ struct thread
 #ifdef USERPROG    
     /* Owned by userprog/process.c. */
     uint32_t *pagedir;                  /* Page directory. */
+    struct file *exec_file;             /* Executable, denied writes. */
+    bool user_access;                   /* In get_user() or put_user()? */
     /* code about chlid process (i added)*/
 
 #endif
@@ -123,8 +125,9 @@ struct thread
     struct semaphore parent_sema2;
     struct semaphore create_sema;
     bool create_success;
-    struct list file_list;
-    struct bitmap* file_bitmap;
+    struct fd_entry *fd_table;          /* Open descriptors, indexed by fd. */
+    int fd_cap;                         /* Number of slots in fd_table. */
+    int fd_free;                        /* Every fd below this is in use. */
 
     struct list_elem block_elem;
     uint64_t ticks;
@@ -133,10 +136,14 @@ struct thread
 #ifdef VM
     /*proj4*/
     struct hash spt;
+    struct list mmap_list;              /* Memory-mapped files. */
+    int next_mapid;                     /* Identifier for the next one. */
+    struct list pinned_list;            /* Pages pinned by this system call. */
 #endif
 
     /*proj5*/
     struct dir *current_dir;
+    int journal_depth;                  /* Nested journal_begin() calls. */
     /* Owned by thread.c. */
     unsigned magic;                     /* Detects stack overflow. */
   };
@@ -177,7 +184,6 @@ void thread_set_nice (int);
 int thread_get_recent_cpu (void);
 int thread_get_load_avg (void);
 
-bool thread_findname_foreach (const char* name);
 void thread_block_with_time(int64_t ticks);
 void block_check(void);
 void thread_aging(void);
@@ -194,5 +200,4 @@ void calculate_load_avg();
 void calculate_recent_cpu();
 void calculate_priority();
 
-void destroy_file_bitmap();
 #endif /* threads/thread.h */
@@ -1,6 +1,7 @@
 #include "userprog/exception.h"
 #include <inttypes.h>
 #include <stdio.h>
+#include <string.h>
 #include "userprog/gdt.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
@@ -9,13 +10,30 @@
 #include <hash.h>
 #include "threads/palloc.h"
 #include "devices/block.h"
+#include "filesys/file.h"
+#include "userprog/pagedir.h"
+#include "userprog/process.h"
 #include "vm/frame.h"
 
+#ifdef VM
+/* Number of pages after a faulting file page that are loaded
+   along with it. */
+#ifndef FAULT_AROUND_PAGES
+#define FAULT_AROUND_PAGES 8
+#endif
+#endif
+
 /* Number of page faults processed. */
 static long long page_fault_cnt;
 
 static void kill (struct intr_frame *);
 static void page_fault (struct intr_frame *);
+static void bad_access (struct intr_frame *, bool user, void *fault_addr);
+#ifdef VM
+static bool load_file_page (struct spt_e *, bool write);
+static bool unzero_page (struct spt_e *);
+static void fault_around (struct spt_e *);
+#endif
 
 /* Registers handlers for interrupts that can be caused by user
    programs.
@@ -155,27 +173,40 @@ page_fault (struct intr_frame *f)
 
 #ifdef VM
   if(is_kernel_vaddr(fault_addr)){
-	  exit(-1);
-  }
-
-  if(!not_present){
-	  exit(-1);
+	  bad_access(f, user, fault_addr);
+	  return;
   }
   struct spt_e find_element;
   find_element.vaddr = pg_round_down(fault_addr);
   struct hash_elem *e = hash_find(&thread_current()->spt,&find_element.elem);
+  if(!not_present){
+	  /* First write to a page still mapped to the zero page. */
+	  if(e != NULL && write){
+		  struct spt_e *spte = hash_entry(e,struct spt_e,elem);
+		  if(spte->writable && frame_is_zero(spte->kpage)){
+			  if(!unzero_page(spte)){
+				  printf("install page error\n");
+				  exit(-1);
+			  }
+			  return;
+		  }
+	  }
+	  bad_access(f, user, fault_addr);
+	  return;
+  }
   if(e == NULL){
 	  bool on_stack_frame,is_stack_addr;
 	  on_stack_frame  = (f->esp <= fault_addr || fault_addr == f->esp - 32);
 	  is_stack_addr = (PHYS_BASE - 0x800000 <= fault_addr && fault_addr < PHYS_BASE);
 	  if(!on_stack_frame || !is_stack_addr){
-		  exit(-1);
+		  bad_access(f, user, fault_addr);
+		  return;
 	  }
 	  else{
 		 uint8_t *vaddr = pg_round_down(fault_addr);
 		 uint8_t *page = frame_allocate(vaddr,PAL_ZERO);
-		 struct thread *t = thread_current();
-		 memset(page,0,PGSIZE);
+		 if(page == NULL)
+			exit(-1);
 		 if(!call_install_page(vaddr,page,true)){ //writable need to edited
 			frame_free(page);
 			printf("install page error\n");
@@ -185,15 +216,21 @@ page_fault (struct intr_frame *f)
 	  }
 	}
   uint8_t *vaddr = pg_round_down(fault_addr);
-  uint8_t *kpage = frame_allocate(vaddr,PAL_USER);
-  if(kpage == NULL){
-	printf("can't use swap partition\n");
-	exit(-1);
-  }
   struct spt_e* found = hash_entry(e,struct spt_e,elem);
-  found->kpage = kpage;
-  //swap in needed to be added.
+
+  /* The page may be on its way out.  If it could not be evicted
+     after all, it is mapped again: just retry the access. */
+  frame_wait_evicted(found);
+  if(found->kpage != NULL)
+	  return;
+
   if(found->swap_slot != -1){
+	uint8_t *kpage = frame_allocate(vaddr,PAL_USER);
+	if(kpage == NULL){
+		printf("can't use swap partition\n");
+		exit(-1);
+	}
+	found->kpage = kpage;
 	swap_to_addr(found->swap_slot,kpage);
 	found->swap_slot = -1;
 	if(!call_install_page(found->vaddr,kpage,found->writable)){
@@ -204,28 +241,17 @@ page_fault (struct intr_frame *f)
 	return;
   }	  
 
-  file_seek(found->file,found->ofs);
-  if(file_read(found->file,kpage,found->page_read_bytes) != (int) found->page_read_bytes){
-	  frame_free(kpage);
+  if(!load_file_page(found, write)){
 	  printf("file read error \n");
 	  exit(-1);
   }
-  memset(kpage + found->page_read_bytes,0,found->page_zero_bytes);
-
-  if(!call_install_page(found->vaddr,kpage,found->writable)){
-	  frame_free(kpage);	
-	  printf("install page error\n");
-	  exit(-1);
-  }
+  fault_around(found);
   return;
 #else
-	if(!user){
-		exit(-1);
+	if(!user || is_kernel_vaddr(fault_addr) || not_present){
+		bad_access(f, user, fault_addr);
+		return;
 	}
-	else if(is_kernel_vaddr(fault_addr))
-		exit(-1);
-	else if(not_present)
-		exit(-1);
 #endif
   /* To implement virtual memory, delete the rest of the function
      body, and replace it with code that brings in the page to
@@ -239,3 +265,117 @@ page_fault (struct intr_frame *f)
   kill (f);
 }
 
+/* Handles an invalid memory access.  If the kernel faulted on a
+   user address inside get_user() or put_user() in
+   userprog/syscall.c, which set the thread's user_access flag and
+   left the address to resume at in eax, continue there with eax
+   set to -1 so the system call can fail cleanly.  Otherwise the
+   process is killed. */
+static void
+bad_access (struct intr_frame *f, bool user, void *fault_addr)
+{
+  struct thread *t = thread_current ();
+
+  if (!user && is_user_vaddr (fault_addr) && t->user_access)
+    {
+      t->user_access = false;
+      f->eip = (void (*) (void)) f->eax;
+      f->eax = 0xffffffff;
+      return;
+    }
+  exit (-1);
+}
+
+#ifdef VM
+/* Brings SPTE's page in from its file, or maps the copy another
+   process already has.  WRITE is true if the page is being
+   brought in to be written.  Returns true if successful, false
+   on failure. */
+static bool
+load_file_page (struct spt_e *spte, bool write)
+{
+  uint8_t *kpage;
+
+  /* A page with nothing to read, such as BSS, is all zeros.  Until
+     it is written, it can be the zero page. */
+  if (!write && spte->page_read_bytes == 0 && !spte->mmap)
+    return frame_map_zero (spte);
+
+  /* Another process running the same program may have this page
+     in memory already. */
+  if (frame_share_map (spte))
+    return true;
+
+  kpage = frame_allocate (spte->vaddr, PAL_USER);
+  if (kpage == NULL)
+    return false;
+  spte->kpage = kpage;
+
+  if (file_read_at (spte->file, kpage, spte->page_read_bytes, spte->ofs)
+      != (int) spte->page_read_bytes)
+    goto fail;
+  memset (kpage + spte->page_read_bytes, 0, spte->page_zero_bytes);
+  if (!call_install_page (spte->vaddr, kpage, spte->writable))
+    goto fail;
+
+  frame_share (spte);
+  return true;
+
+ fail:
+  spte->kpage = NULL;
+  frame_free (kpage);
+  return false;
+}
+
+/* Gives SPTE, which is mapped to the zero page, a zeroed frame
+   of its own and maps it writable.  Returns true if successful,
+   false on failure. */
+static bool
+unzero_page (struct spt_e *spte)
+{
+  uint8_t *kpage;
+
+  pagedir_clear_page (thread_current ()->pagedir, spte->vaddr);
+  spte->kpage = NULL;
+
+  kpage = frame_allocate (spte->vaddr, PAL_ZERO);
+  if (kpage == NULL)
+    return false;
+  spte->kpage = kpage;
+  if (!call_install_page (spte->vaddr, kpage, true))
+    {
+      spte->kpage = NULL;
+      frame_free (kpage);
+      return false;
+    }
+  return true;
+}
+
+/* Loads the pages that follow SPTE, up to FAULT_AROUND_PAGES of
+   them, on the bet that a process reading its text or a mapped
+   file will touch them soon.  Stops at the end of SPTE's run of
+   file pages, and whenever free frames run short, so that it
+   never forces an eviction. */
+static void
+fault_around (struct spt_e *spte)
+{
+  struct thread *t = thread_current ();
+  int i;
+
+  for (i = 1; i <= FAULT_AROUND_PAGES && frame_plentiful (); i++)
+    {
+      struct spt_e *next = spte_lookup (&t->spt,
+                                        (uint8_t *) spte->vaddr + i * PGSIZE);
+
+      if (next == NULL
+          || next->file != spte->file
+          || next->ofs != spte->ofs + i * PGSIZE
+          || next->writable != spte->writable
+          || next->mmap != spte->mmap
+          || next->swap_slot != -1)
+        break;
+      if (next->kpage == NULL && !load_file_page (next, false))
+        break;
+    }
+}
+#endif
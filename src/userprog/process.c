@@ -1,4 +1,5 @@
 #include "userprog/process.h" 
+#include <console.h>
 #include <debug.h>
 #include <inttypes.h>
 #include <round.h>
@@ -7,10 +8,12 @@
 #include <string.h>
 #include "userprog/gdt.h"
 #include "userprog/pagedir.h"
+#include "userprog/syscall.h"
 #include "userprog/tss.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
@@ -18,6 +21,8 @@
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "threads/malloc.h"
+#include "vm/frame.h"
+#include "vm/mmap.h"
 #include "vm/page.h"
 #include "vm/swap.h"
 
@@ -137,19 +142,19 @@ process_exit (void)
 
   /* Destroy the current process's page directory and switch back
      to the kernel-only page directory. */
-  struct list_elem* elem;
-  struct list_item* item;
-  for(elem = list_begin(&(cur->file_list));
-  	  elem != list_end(&(cur->file_list));){
-	  	  item = list_entry(elem,struct list_item,elem);
-		  file_close(item->f);
-		  elem = list_remove(elem);
-		  free(item);
-	  }
-  destroy_file_bitmap();
+  fd_close_all();
 #ifdef VM
+  frame_unpin_user_all();
+  mmap_unmap_all();
   hash_destroy(&cur->spt,spte_destroy);
 #endif
+  if (cur->exec_file != NULL)
+    {
+      /* No page can be loaded from it any more. */
+      inode_exec_end (file_get_inode (cur->exec_file));
+      file_close (cur->exec_file);
+      cur->exec_file = NULL;
+    }
 
   sema_up(&(cur->parent_sema));
   sema_down(&(cur->parent_sema2));
@@ -315,10 +320,14 @@ load (const char *file_name, void (**eip) (void), void **esp)
   file = filesys_open (argv[0]);
   if (file == NULL) 
     {
-      printf ("load: %s: open failed\n", argv[0]);
+      klog_printf ("load: %s: open failed\n", argv[0]);
       goto done; 
     }
 
+  /* Keep it open, and unwritable, until process_exit(). */
+  t->exec_file = file;
+  inode_exec_begin (file_get_inode (file));
+
   /* Read and verify executable header. */
   if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr
       || memcmp (ehdr.e_ident, "\177ELF\1\1\1", 7)
@@ -329,7 +338,7 @@ load (const char *file_name, void (**eip) (void), void **esp)
       || ehdr.e_phnum > 1024)
        
     {
-      printf ("load: %s: error loading executable\n", file_name);
+      klog_printf ("load: %s: error loading executable\n", file_name);
       goto done; 
     }
 
@@ -405,8 +414,8 @@ load (const char *file_name, void (**eip) (void), void **esp)
 
  done:
   /* We arrive here whether the load is successful or not. */
-  //proj4 edited
-  //file_close (file);
+  /* FILE stays open as t->exec_file; the VM loads pages from it
+     lazily. */
   return success;
 }
 
@@ -532,13 +541,12 @@ setup_stack (void **esp)
 
 #ifdef VM
   kpage = frame_allocate(((uint8_t *)PHYS_BASE)-PGSIZE,PAL_ZERO);
-  memset(kpage,0,PGSIZE);
 #else
   kpage = palloc_get_page(PAL_USER | PAL_ZERO);
 #endif
   if (kpage != NULL) 
     {
-      success = install_page (((uint8_t *) PHYS_BASE) - PGSIZE, kpage, true);
+      success = call_install_page (((uint8_t *) PHYS_BASE) - PGSIZE, kpage, true);
       if (success)
         *esp = PHYS_BASE;
       else
@@ -606,6 +614,13 @@ void push_argument(int argc, char* argv[], void** esp)
   *esp -= 4;
 
 }
+/* Maps KPAGE, a frame from frame_allocate(), at UPAGE and lets
+   it be evicted from then on. */
 bool call_install_page(void *upage,void* kpage, bool writable){
-	return install_page(upage,kpage,writable);
+	if(!install_page(upage,kpage,writable))
+		return false;
+#ifdef VM
+	frame_unpin(kpage);
+#endif
+	return true;
 }
@@ -7,5 +7,6 @@ tid_t process_execute (const char *file_name);
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (void);
+bool call_install_page (void *upage, void *kpage, bool writable);
 
 #endif /* userprog/process.h */
@@ -1,169 +1,508 @@
 #include "userprog/syscall.h"
+#include <console.h>
 #include <stdio.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <string.h>
+#include <iovec.h>
+#include <ring.h>
+#include <syscall-stats.h>
 #include <syscall-nr.h>
+#include "devices/tty.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "filesys/directory.h"
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "filesys/inode.h"
+#include "userprog/pagedir.h"
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/mmap.h"
+#endif
 
 static void syscall_handler (struct intr_frame *);
-static struct lock filesys_lock;
+
+int ring_enter(struct ring *ring);
+int get_syscall_stats(struct syscall_stats *ustats, unsigned cnt, bool reset);
+int dmesg(char *buffer, unsigned size);
 
 #ifdef FILESYS
-bool chdir(const char *filename);
-bool mkdir(const char *filename);
-bool readdir(int fd, char *filename);
-bool isdir(int fd);
+/* Handlers return int, never bool, because the dispatcher stores
+   all of eax and a bool return only defines al. */
+int chdir(const char *filename);
+int mkdir(const char *filename);
+int readdir(int fd, char *filename);
+int isdir(int fd);
 int inumber(int fd);
+int fsync(int fd);
+void sync(void);
+int pread(int fd, void *buffer, unsigned size, unsigned ofs);
+int pwrite(int fd, const void *buffer, unsigned size, unsigned ofs);
+int readv(int fd, const struct iovec *iov, int cnt);
+int writev(int fd, const struct iovec *iov, int cnt);
+int copy_file_range(int fd_in, int fd_out, unsigned length);
 #endif
 
-struct list_item* get_fd(struct thread*,int fd,bool directory, bool file);
+#ifdef VM
+int mmap(int fd, void *addr);
+void munmap(int mapid);
+#endif
+
+#define FD_INIT_CNT 16                  /* Initial table size. */
+#define FD_MAX 512                      /* Maximum table size. */
+
+struct fd_entry* get_fd(struct thread*,int fd,bool directory, bool file);
+static int fd_alloc(struct thread *, struct file *, struct dir *);
 
 void
 syscall_init (void) 
 {
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
-  lock_init(&filesys_lock);
 }
 
+/* Kinds of system call arguments.  Every argument occupies one
+   32-bit word on the user stack. */
+enum syscall_arg
+  {
+    ARG_INT,                    /* Plain value, passed through. */
+    ARG_PTR                     /* User pointer, must be below PHYS_BASE. */
+  };
+
+#define SYSCALL_MAX_ARGS 4
+
+/* Decodes a system call's arguments from the words in ARGV, calls
+   it, and returns what it leaves in eax. */
+typedef uint32_t syscall_func (const uint32_t *argv);
+
+/* Dispatch table entry. */
+struct syscall
+  {
+    const char *name;           /* Name, for statistics. */
+    syscall_func *func;         /* Implementation. */
+    int argc;                   /* Number of arguments. */
+    enum syscall_arg args[SYSCALL_MAX_ARGS];
+    bool retval;                /* Does it return a value in eax? */
+  };
+
+#define SYSCALL(FUNC, ARGC, RETVAL, ...) \
+	{ #FUNC, sys_##FUNC, ARGC, { __VA_ARGS__ }, RETVAL }
+
+/* Defines sys_FUNC(), a syscall_func that calls FUNC with the
+   argument expressions that follow, written in terms of ARGV.
+   SYSCALL_VOID is for a FUNC that returns nothing. */
+#define SYSCALL_WRAP(FUNC, ...) \
+	static uint32_t sys_##FUNC(const uint32_t *argv UNUSED) \
+	{ return (uint32_t) FUNC(__VA_ARGS__); }
+#define SYSCALL_VOID(FUNC, ...) \
+	static uint32_t sys_##FUNC(const uint32_t *argv UNUSED) \
+	{ FUNC(__VA_ARGS__); return 0; }
+
+SYSCALL_VOID(halt, )
+SYSCALL_VOID(exit, (int) argv[0])
+SYSCALL_WRAP(exec, (const char *) argv[0])
+SYSCALL_WRAP(wait, (int) argv[0])
+SYSCALL_WRAP(create, (const char *) argv[0], (unsigned) argv[1])
+SYSCALL_WRAP(remove, (const char *) argv[0])
+SYSCALL_WRAP(open, (const char *) argv[0])
+SYSCALL_WRAP(filesize, (int) argv[0])
+SYSCALL_WRAP(read, (int) argv[0], (int *) argv[1], (unsigned) argv[2])
+SYSCALL_WRAP(write, (int) argv[0], (int *) argv[1], (unsigned) argv[2])
+SYSCALL_VOID(seek, (int) argv[0], (unsigned) argv[1])
+SYSCALL_WRAP(tell, (int) argv[0])
+SYSCALL_VOID(close, (int) argv[0])
+SYSCALL_WRAP(fibonacci, (int) argv[0])
+SYSCALL_WRAP(max_of_four_int, (int) argv[0], (int) argv[1], (int) argv[2],
+             (int) argv[3])
+SYSCALL_WRAP(ring_enter, (struct ring *) argv[0])
+SYSCALL_WRAP(get_syscall_stats, (struct syscall_stats *) argv[0],
+             (unsigned) argv[1], argv[2] != 0)
+SYSCALL_WRAP(dmesg, (char *) argv[0], (unsigned) argv[1])
+#ifdef FILESYS
+SYSCALL_WRAP(chdir, (const char *) argv[0])
+SYSCALL_WRAP(mkdir, (const char *) argv[0])
+SYSCALL_WRAP(readdir, (int) argv[0], (char *) argv[1])
+SYSCALL_WRAP(isdir, (int) argv[0])
+SYSCALL_WRAP(inumber, (int) argv[0])
+SYSCALL_WRAP(fsync, (int) argv[0])
+SYSCALL_VOID(sync, )
+SYSCALL_WRAP(pread, (int) argv[0], (void *) argv[1], (unsigned) argv[2],
+             (unsigned) argv[3])
+SYSCALL_WRAP(pwrite, (int) argv[0], (const void *) argv[1],
+             (unsigned) argv[2], (unsigned) argv[3])
+SYSCALL_WRAP(readv, (int) argv[0], (const struct iovec *) argv[1],
+             (int) argv[2])
+SYSCALL_WRAP(writev, (int) argv[0], (const struct iovec *) argv[1],
+             (int) argv[2])
+SYSCALL_WRAP(copy_file_range, (int) argv[0], (int) argv[1],
+             (unsigned) argv[2])
+#endif
+#ifdef VM
+SYSCALL_WRAP(mmap, (int) argv[0], (void *) argv[1])
+SYSCALL_VOID(munmap, (int) argv[0])
+#endif
+
+/* System calls indexed by SYS_* number.  Unimplemented numbers are
+   left zeroed. */
+static const struct syscall syscall_table[] =
+  {
+    [SYS_HALT] = SYSCALL(halt, 0, false),
+    [SYS_EXIT] = SYSCALL(exit, 1, false, ARG_INT),
+    [SYS_EXEC] = SYSCALL(exec, 1, true, ARG_PTR),
+    [SYS_WAIT] = SYSCALL(wait, 1, true, ARG_INT),
+    [SYS_CREATE] = SYSCALL(create, 2, true, ARG_PTR, ARG_INT),
+    [SYS_REMOVE] = SYSCALL(remove, 1, true, ARG_PTR),
+    [SYS_OPEN] = SYSCALL(open, 1, true, ARG_PTR),
+    [SYS_FILESIZE] = SYSCALL(filesize, 1, true, ARG_INT),
+    [SYS_READ] = SYSCALL(read, 3, true, ARG_INT, ARG_PTR, ARG_INT),
+    [SYS_WRITE] = SYSCALL(write, 3, true, ARG_INT, ARG_PTR, ARG_INT),
+    [SYS_SEEK] = SYSCALL(seek, 2, false, ARG_INT, ARG_INT),
+    [SYS_TELL] = SYSCALL(tell, 1, true, ARG_INT),
+    [SYS_CLOSE] = SYSCALL(close, 1, false, ARG_INT),
+    [SYS_FIBONACCI] = SYSCALL(fibonacci, 1, true, ARG_INT),
+    [SYS_MAXOFFOURINT] = SYSCALL(max_of_four_int, 4, true,
+                                 ARG_INT, ARG_INT, ARG_INT, ARG_INT),
+    [SYS_RING_ENTER] = SYSCALL(ring_enter, 1, true, ARG_PTR),
+    [SYS_SYSCALL_STATS] = SYSCALL(get_syscall_stats, 3, true,
+                                  ARG_PTR, ARG_INT, ARG_INT),
+    [SYS_DMESG] = SYSCALL(dmesg, 2, true, ARG_PTR, ARG_INT),
+#ifdef FILESYS
+    [SYS_CHDIR] = SYSCALL(chdir, 1, true, ARG_PTR),
+    [SYS_MKDIR] = SYSCALL(mkdir, 1, true, ARG_PTR),
+    [SYS_READDIR] = SYSCALL(readdir, 2, true, ARG_INT, ARG_PTR),
+    [SYS_ISDIR] = SYSCALL(isdir, 1, true, ARG_INT),
+    [SYS_INUMBER] = SYSCALL(inumber, 1, true, ARG_INT),
+    [SYS_FSYNC] = SYSCALL(fsync, 1, true, ARG_INT),
+    [SYS_SYNC] = SYSCALL(sync, 0, false),
+    [SYS_PREAD] = SYSCALL(pread, 4, true, ARG_INT, ARG_PTR, ARG_INT, ARG_INT),
+    [SYS_PWRITE] = SYSCALL(pwrite, 4, true, ARG_INT, ARG_PTR, ARG_INT, ARG_INT),
+    [SYS_READV] = SYSCALL(readv, 3, true, ARG_INT, ARG_PTR, ARG_INT),
+    [SYS_WRITEV] = SYSCALL(writev, 3, true, ARG_INT, ARG_PTR, ARG_INT),
+    [SYS_COPY_FILE_RANGE] = SYSCALL(copy_file_range, 3, true,
+                                    ARG_INT, ARG_INT, ARG_INT),
+#endif
+#ifdef VM
+    /* ADDR may be any value: mmap() rejects a bad one with an
+       error rather than killing the process. */
+    [SYS_MMAP] = SYSCALL(mmap, 2, true, ARG_INT, ARG_INT),
+    [SYS_MUNMAP] = SYSCALL(munmap, 1, false, ARG_INT),
+#endif
+  };
+
+#define SYSCALL_CNT (sizeof syscall_table / sizeof *syscall_table)
+
+/* Per-call statistics, indexed like syscall_table.  Calls that do
+   not return, such as exit and halt, are not recorded. */
+static struct syscall_stats stats[SYSCALL_CNT];
+
+/* Returns the CPU's time-stamp counter. */
+static inline uint64_t
+rdtsc(void)
+{
+	uint64_t tsc;
+	asm volatile ("rdtsc" : "=A" (tsc));
+	return tsc;
+}
+
+/* Adds one call to SYSCALL_NO that took CYCLES. */
 static void
-syscall_handler (struct intr_frame *f) 
+stats_record(unsigned syscall_no, uint64_t cycles)
 {
-  int syscall_no = *(int*)(f->esp);
+	struct syscall_stats *s = &stats[syscall_no];
+	int bucket = 0;
+	enum intr_level old_level;
+
+	while (bucket < SYSCALL_STATS_BUCKETS - 1 && (cycles >> (bucket + 1)) != 0)
+		bucket++;
+
+	old_level = intr_disable();
+	s->cnt++;
+	s->cycles += cycles;
+	s->hist[bucket]++;
+	intr_set_level(old_level);
+}
 
-  if(!is_user_vaddr(f->esp)){
-	  exit(-1);
-  }
+/* User memory access.
+
+   The kernel dereferences user pointers directly instead of
+   walking the page directory first.  Every access goes through
+   get_user() or put_user(), which load the address of the
+   instruction following the access into eax beforehand, and set
+   the thread's user_access flag around it.  If the access faults,
+   page_fault() sees the flag and resumes there with eax set to -1,
+   so a bad pointer costs a page fault while a good one costs
+   nothing extra.  The addresses must already be known to lie
+   below PHYS_BASE, since kernel addresses never fault. */
+
+/* Reads a byte at user address UADDR.
+   Returns the byte value if successful, -1 if a fault occurred. */
+static inline int
+get_user(const uint8_t *uaddr)
+{
+	struct thread *t = thread_current();
+	int result;
+
+	t->user_access = true;
+	asm volatile ("movl $1f, %0; movzbl %1, %0; 1:"
+	              : "=&a" (result) : "m" (*uaddr) : "memory");
+	t->user_access = false;
+	return result;
+}
 
-  if(syscall_no == SYS_HALT){
-	  halt();
-  }
-  else if(syscall_no == SYS_EXIT){
-	  if(!is_user_vaddr(f->esp + 4))
-		  exit(-1);
-	exit(*(int*)(f->esp + 4));
-  }
-  else if(syscall_no == SYS_EXEC){
-	  if(!is_user_vaddr(f->esp + 4))
-		  exit(-1);
-	 f->eax = exec(*(int*)(f->esp + 4));
-  }
-  else if(syscall_no == SYS_WAIT){
-	  if(!is_user_vaddr(f->esp + 4))
-		  exit(-1);
-	f->eax = wait(*(int*)(f->esp + 4));
-  }
-  else if(syscall_no == SYS_READ){
-	  if(!is_user_vaddr(f->esp + 4) || !is_user_vaddr(f->esp + 8) || !is_user_vaddr(f->esp + 12))
-		  exit(-1);
-	f->eax = read(*(int*)(f->esp+4),*(int*)(f->esp+8),*(unsigned*)(f->esp+12));
-  }
-  else if(syscall_no == SYS_WRITE){
-	  if(!is_user_vaddr(f->esp + 4) || !is_user_vaddr(f->esp + 8) || !is_user_vaddr(f->esp + 12))
-		  exit(-1);
-	f->eax = write(*(int*)(f->esp + 4),*(int*)(f->esp+8),*(unsigned*)(f->esp+12));
-  }
-  else if(syscall_no == SYS_FIBONACCI){
-	if(!is_user_vaddr(f->esp + 4))
-		exit(-1);
-	f->eax = fibonacci(*(int*)(f->esp + 4));
+/* Writes BYTE to user address UDST.
+   Returns true if successful, false if a fault occurred. */
+static inline bool
+put_user(uint8_t *udst, uint8_t byte)
+{
+	struct thread *t = thread_current();
+	int error_code;
+
+	t->user_access = true;
+	asm volatile ("movl $1f, %0; movb %b2, %1; 1:"
+	              : "=&a" (error_code), "=m" (*udst) : "q" (byte)
+	              : "memory");
+	t->user_access = false;
+	return error_code != -1;
+}
 
-  }
-  else if(syscall_no == SYS_MAXOFFOURINT){
-	  if(!is_user_vaddr(f->esp + 4) || !is_user_vaddr(f->esp + 8) || !is_user_vaddr(f->esp + 12) ||
-			  !is_user_vaddr(f->esp + 16))
-		  exit(-1);
-	f->eax = max_of_four_int(*(int*)(f->esp+4),*(int*)(f->esp+8),*(int*)(f->esp+12),*(int*)(f->esp+16));
-  }
-  else if(syscall_no == SYS_CREATE){
-	if(!is_user_vaddr(f->esp+4) || !is_user_vaddr(f->esp + 8))
+/* Returns true if [UADDR, UADDR + SIZE) lies in user space. */
+static bool
+check_user_range(const void *uaddr, size_t size)
+{
+	const uint8_t *start = uaddr;
+
+	return size == 0 || (start + size > start && is_user_vaddr(start + size - 1));
+}
+
+/* Copies SIZE bytes from user address USRC to DST.
+   Returns false on a bad address. */
+static bool
+copy_in(void *dst_, const void *usrc_, size_t size)
+{
+	uint8_t *dst = dst_;
+	const uint8_t *usrc = usrc_;
+
+	if (!check_user_range(usrc, size))
+		return false;
+	for (; size > 0; size--) {
+		int byte = get_user(usrc++);
+		if (byte == -1)
+			return false;
+		*dst++ = byte;
+	}
+	return true;
+}
+
+/* Copies SIZE bytes from SRC to user address UDST.
+   Returns false on a bad address. */
+static bool
+copy_out(void *udst_, const void *src_, size_t size)
+{
+	uint8_t *udst = udst_;
+	const uint8_t *src = src_;
+
+	if (!check_user_range(udst, size))
+		return false;
+	for (; size > 0; size--)
+		if (!put_user(udst++, *src++))
+			return false;
+	return true;
+}
+
+/* Copies the null-terminated string at user address US into a
+   new page, which the caller must free with palloc_free_page().
+   Kills the process on a bad address or if the string does not
+   fit in a page. */
+static char *
+copy_in_string(const char *us)
+{
+	char *ks = palloc_get_page(0);
+	size_t i;
+
+	if (ks == NULL)
 		exit(-1);
+	for (i = 0; i < PGSIZE; i++) {
+		int byte;
+		if (!is_user_vaddr(us + i) || (byte = get_user((const uint8_t *) us + i)) == -1) {
+			palloc_free_page(ks);
+			exit(-1);
+		}
+		if ((ks[i] = byte) == '\0')
+			return ks;
+	}
+	palloc_free_page(ks);
+	exit(-1);
+}
 
-	  f->eax = create(*(const char**)(f->esp+4),*(unsigned*)(f->esp+8));
-  }
-  else if(syscall_no == SYS_REMOVE){
-	  if(!is_user_vaddr(f->esp + 4))
-		  exit(-1);
-	  f->eax = remove(*(const char**)(f->esp+4));
-  }
-  else if(syscall_no == SYS_OPEN){
-	  if(!is_user_vaddr(f->esp + 4))
-		  exit(-1);
-	  f->eax = open(*(const char**)(f->esp+4));
-  }
-  else if(syscall_no == SYS_FILESIZE){
-	  if(!is_user_vaddr(f->esp + 4))
-		  exit(-1);
-	  f->eax = filesize(*(int*)(f->esp+4));
-  }
-  else if(syscall_no == SYS_SEEK){
-	  if(!is_user_vaddr(f->esp + 4)||!is_user_vaddr(f->esp+8))
-		  exit(-1);
-	  seek(*(int*)(f->esp+4),*(int*)(f->esp+8));
-  }
-  else if(syscall_no == SYS_TELL){
-	  if(!is_user_vaddr(f->esp+4))
-		 exit(-1);
-	  f->eax = tell(*(int*)(f->esp+4));
-  }
-  else if(syscall_no == SYS_CLOSE){
-	  if(!is_user_vaddr(f->esp + 4))
-		  exit(-1); 
-	  close(*(int*)(f->esp+4));
-  }
-#ifdef FILESYS
-  else if(syscall_no ==  SYS_CHDIR)
-  {
-	  int return_code;
+/* Returns true if copy_in_string() would accept US. */
+static bool
+check_user_string(const char *us)
+{
+	size_t i;
+
+	for (i = 0; i < PGSIZE; i++) {
+		int byte;
+		if (!is_user_vaddr(us + i) || (byte = get_user((const uint8_t *) us + i)) == -1)
+			return false;
+		if (byte == '\0')
+			return true;
+	}
+	return false;
+}
 
-	  if (!is_user_vaddr(f->esp + 4))
-		  exit(-1);
+/* Largest part of a user buffer pinned at once.  Bigger reads
+   and writes are done in pieces of this size, so that one system
+   call cannot pin so many frames that nothing is left to evict. */
+#define PIN_CHUNK (16 * PGSIZE)
+
+/* Returns true if the resident user page containing UADDR, whose
+   byte at UADDR is BYTE, may be written.  This is decided from the
+   page's permissions, not by storing to it, so that probing does
+   not dirty clean file pages. */
+static bool
+user_page_writable(uint8_t *uaddr, int byte)
+{
+#ifdef VM
+	struct spt_e *spte = spte_lookup(&thread_current()->spt,
+		pg_round_down(uaddr));
 
-	  f->eax = chdir(*(int*)(f->esp + 4));
-  }
+	if (spte == NULL || !spte->writable)
+		return false;
+	/* A page still mapped to the shared zero page needs a frame of
+	   its own before the kernel writes it.  Storing to it gets one,
+	   and dirties nothing but a page of zeros. */
+	if (frame_is_zero(spte->kpage))
+		return put_user(uaddr, byte);
+	return true;
+#else
+	(void) byte;
+	return pagedir_is_writable(thread_current()->pagedir, uaddr);
+#endif
+}
 
-  else if(syscall_no == SYS_MKDIR)
-  {
-	  int return_code;
+/* Keeps the user page containing UADDR resident until
+   unpin_user_pages().  Returns false if it was evicted after it
+   was touched, so it must be touched again. */
+static bool
+pin_user_page(const void *uaddr UNUSED)
+{
+#ifdef VM
+	return frame_pin_user(pg_round_down(uaddr));
+#else
+	return true;
+#endif
+}
 
-	  if (!is_user_vaddr(f->esp + 4))
-		  exit(-1);
+/* Releases every page pinned by pin_user_buffer(). */
+static void
+unpin_user_pages(void)
+{
+#ifdef VM
+	frame_unpin_user_all();
+#endif
+}
 
-	  f->eax = mkdir(*(int*)(f->esp + 4));
+/* Touches one byte in each page of the SIZE-byte user buffer
+   UBUF, and checks that the page may be written if WRITABLE.
+   If PIN, also pins each page.  Returns false on a bad address. */
+static bool
+probe_user_buffer(const void *ubuf, size_t size, bool writable, bool pin)
+{
+	uint8_t *p = (uint8_t *) ubuf;
+	uint8_t *end = p + size;
 
-  }
+	if (!check_user_range(ubuf, size))
+		return false;
+	for (; p < end; p = (uint8_t *) pg_round_down(p) + PGSIZE) {
+		do {
+			int byte = get_user(p);
+			if (byte == -1 || (writable && !user_page_writable(p, byte)))
+				return false;
+		} while (pin && !pin_user_page(p));
+	}
+	return true;
+}
 
-  else if(syscall_no == SYS_READDIR)
-  {
-	  int return_code;
+/* Makes sure every page of the SIZE-byte user buffer UBUF can be
+   read, or written too if WRITABLE.  Returns false on a bad
+   address. */
+static bool
+check_user_buffer(const void *ubuf, size_t size, bool writable)
+{
+	return probe_user_buffer(ubuf, size, writable, false);
+}
 
-	  if (!is_user_vaddr(f->esp + 4)|| !is_user_vaddr(f->esp + 8))
-		  exit(-1);
-	  f->eax = readdir(*(int*)(f->esp + 4), *(int*)(f->esp + 8));
-  }
+/* Like check_user_buffer(), but also pins the buffer's pages in
+   memory until unpin_user_pages(), so that file system code can
+   access it while holding locks the page fault handler might
+   need.  SIZE should be at most PIN_CHUNK. */
+static bool
+pin_user_buffer(const void *ubuf, size_t size, bool writable)
+{
+	return probe_user_buffer(ubuf, size, writable, true);
+}
 
-  else if(syscall_no == SYS_ISDIR)
-  {
-	  int return_code;
+/* Copies the system call number and the ARGC words after it from
+   the user stack at ESP into ARGV.  Kills the process if any of
+   it is not mapped user memory. */
+static void
+fetch_args(const uint32_t *esp, uint32_t *argv, int argc)
+{
+	if (!copy_in(argv, esp + 1, argc * sizeof *argv))
+		exit(-1);
+}
 
-	  if (!is_user_vaddr(f->esp + 4))
-		  exit(-1);
+static void
+syscall_handler (struct intr_frame *f) 
+{
+  const struct syscall *sc;
+  uint32_t argv[SYSCALL_MAX_ARGS] = { 0 };
+  unsigned syscall_no;
+  uint32_t ret;
+  uint64_t start = rdtsc();
 
-	  f->eax = isdir(*(int*)(f->esp + 4));
+  if (!copy_in(&syscall_no, f->esp, sizeof syscall_no))
+	  exit(-1);
+  if (syscall_no >= SYSCALL_CNT || syscall_table[syscall_no].func == NULL) {
+	  f->eax = -1;
+	  return;
   }
+  sc = &syscall_table[syscall_no];
 
-  else if(syscall_no ==SYS_INUMBER)
-  {
-	  int return_code;
-
-	  if (!is_user_vaddr(f->esp + 4))
+  fetch_args(f->esp, argv, sc->argc);
+  for (int i = 0; i < sc->argc; i++)
+	  if (sc->args[i] == ARG_PTR && !is_user_vaddr((void *) argv[i]))
 		  exit(-1);
 
-	  f->eax = inumber(*(int*)(f->esp + 4));
-  }
+  ret = sc->func(argv);
+  if (sc->retval)
+	  f->eax = ret;
+  unpin_user_pages();
 
-#endif
+  stats_record(syscall_no, rdtsc() - start);
+}
 
-  //thread_exit ();
+/* Prints system call statistics. */
+void
+syscall_print_stats (void)
+{
+  for (unsigned i = 0; i < SYSCALL_CNT; i++)
+    {
+      const struct syscall_stats *s = &stats[i];
+
+      if (s->cnt == 0)
+        continue;
+      printf ("Syscall %s: %llu calls, %llu cycles average\n",
+              syscall_table[i].name, s->cnt, s->cycles / s->cnt);
+      printf ("  log2(cycles):");
+      for (int b = 0; b < SYSCALL_STATS_BUCKETS; b++)
+        if (s->hist[b] != 0)
+          printf (" %d:%"PRIu32, b, s->hist[b]);
+      printf ("\n");
+    }
 }
 
 void halt(){
@@ -172,12 +511,14 @@ void halt(){
 void exit(int exit_number){
 
   thread_current()->exit_number = exit_number;
-  printf("%s: exit(%d)\n",thread_current()->name,exit_number);
+  klog_printf("%s: exit(%d)\n",thread_current()->name,exit_number);
   thread_exit();
 
 }
 int exec(const char* filename){
-	 int pid =  process_execute(filename);
+	 char *kfile = copy_in_string(filename);
+	 int pid =  process_execute(kfile);
+	 palloc_free_page(kfile);
 	 return pid;
 }
 int wait(int pid){
@@ -185,70 +526,98 @@ int wait(int pid){
 }
 int read(int fd,int *buffer,unsigned size){
 	
-	if(!is_user_vaddr(buffer)){
+	if(!check_user_buffer(buffer, size, true))
 		exit(-1);
-	}
 	if(fd == 0){
-		for(int i=0; i<size; i++){
-			*buffer = input_getc();
-			if(*buffer != '\0')
-				buffer++;
-			else{ 
-				size = i;
-				break;
-			}
-		}
-		return size; 
+		/* A line at most, copied out in one go.  BUFFER is
+		   only checked, not pinned, since this may wait on the
+		   keyboard for a long time. */
+		char line[TTY_LINE_MAX];
+		size_t n = tty_read(line, size < sizeof line ? size : sizeof line);
+		if(!copy_out(buffer, line, n))
+			exit(-1);
+		return n;
 	}
 	else{
-		struct list_elem* elem;
-		struct list_item* item;
+		struct fd_entry* item = get_fd(thread_current(), fd, true, true);
+		uint8_t *p = (uint8_t *) buffer;
 		unsigned r_size = 0;
-		for(elem = list_begin(&(thread_current()->file_list));
-			elem != list_end(&(thread_current()->file_list)); elem = list_next(elem)){
-			if((item = list_entry(elem,struct list_item,elem))->fd == fd){
-				file_read_sema_down(item->f);
-				r_size =  file_read(item->f,buffer,size);
-				file_read_sema_up(item->f);
-				return r_size;
-			}
+		if(item == NULL)
+			return 0;
+		while(r_size < size){
+			unsigned n = size - r_size < PIN_CHUNK ? size - r_size : PIN_CHUNK;
+			off_t got;
+			if(!pin_user_buffer(p + r_size, n, true))
+				exit(-1);
+			file_read_sema_down(item->f);
+			got = file_read(item->f,p + r_size,n);
+			file_read_sema_up(item->f);
+			unpin_user_pages();
+			r_size += got;
+			if(got < (off_t) n)
+				break;
 		}
-		return 0;
+		return r_size;
 	}
 }
+/* Writes SIZE bytes from user buffer UBUF to the console,
+   bouncing them through a kernel page, because putbuf() must not
+   fault.  Returns false if UBUF is bad or no page is free. */
+static bool console_write(const void *ubuf, size_t size)
+{
+	const uint8_t *usrc = ubuf;
+	char *page;
+
+	if(size == 0)
+		return true;
+	page = palloc_get_page(0);
+	if(page == NULL)
+		return false;
+	while(size > 0){
+		size_t n = size < PGSIZE ? size : PGSIZE;
+		if(!copy_in(page, usrc, n)){
+			palloc_free_page(page);
+			return false;
+		}
+		putbuf(page, n);
+		usrc += n;
+		size -= n;
+	}
+	palloc_free_page(page);
+	return true;
+}
+
 int write(int fd,int *buffer,unsigned size){
-	if(!is_user_vaddr(buffer)){
+	if(!check_user_buffer(buffer, size, false))
 		exit(-1);
-	}
 	if(fd == 1){
-		putbuf((const char*)buffer,size);
+		if(!console_write(buffer, size))
+			exit(-1);
 		return size;
 	}
 	else{
-		
-		struct list_elem* elem;
-		struct list_item* item;
+		struct fd_entry* item = get_fd(thread_current(), fd, true, true);
+		const uint8_t *p = (const uint8_t *) buffer;
 		unsigned w_size = 0;
-		for(elem = list_begin(&(thread_current()->file_list));
-			elem != list_end(&(thread_current()->file_list)); elem = list_next(elem)){
-			if((item = list_entry(elem,struct list_item,elem))->fd == fd){
-				
-				if(item->dir != NULL){
-					return -1;
-				}
-				else{
-					file_write_sema_down(item->f);
-					w_size = file_write(item->f,buffer,size);
-					file_write_sema_up(item->f);
-					return  w_size;
-					
-				}
-			}
+		if(item == NULL)
+			return 0;
+		if(item->dir != NULL)
+			return -1;
+		while(w_size < size){
+			unsigned n = size - w_size < PIN_CHUNK ? size - w_size : PIN_CHUNK;
+			off_t put;
+			if(!pin_user_buffer(p + w_size, n, false))
+				exit(-1);
+			file_write_sema_down(item->f);
+			put = file_write(item->f,p + w_size,n);
+			file_write_sema_up(item->f);
+			unpin_user_pages();
+			w_size += put;
+			if(put < (off_t) n)
+				break;
 		}
-		return 0;
-
+		return  w_size;
 	}
-	
 }
 int fibonacci(int n){
 	if( n <= 0)
@@ -275,15 +644,15 @@ int create(const char* file, unsigned initial_size){
 	if(file == NULL){
 		exit(-1);
 	}
-	//lock_acquire(&filesys_lock);
-	ret = filesys_create(file,initial_size,false);
-	//lock_release(&filesys_lock);
+	char *kfile = copy_in_string(file);
+	ret = filesys_create(kfile,initial_size,false);
+	palloc_free_page(kfile);
 	return ret;
 }
 int remove(const char* file){
-	//lock_acquire(&filesys_lock);
-	int ret = filesys_remove(file);
-	//lock_release(&filesys_lock);
+	char *kfile = copy_in_string(file);
+	int ret = filesys_remove(kfile);
+	palloc_free_page(kfile);
 
 	return ret;
 }
@@ -292,246 +661,558 @@ int open(const char* file){
 	if(file == NULL){
 		return -1;
 	}
-	//lock_acquire(&filesys_lock);
-	struct file* f = filesys_open(file);
+	char *kfile = copy_in_string(file);
+	struct file* f = filesys_open(kfile);
 	int fd = -1;
 	if(f == NULL){
-	 	//lock_release(&filesys_lock);
+		palloc_free_page(kfile);
 		return -1;
 	}
 
-	if(thread_current()->file_bitmap == NULL){
-		thread_current()->file_bitmap = bitmap_create(512);
-		bitmap_set(thread_current()->file_bitmap,0,true);
-		bitmap_set(thread_current()->file_bitmap,1,true);
-	}
-	
-	for(int i=2; i<=511; i++){
-		if(bitmap_count(thread_current()->file_bitmap,i,1,false) == 1){
-			fd = i;
-			bitmap_set(thread_current()->file_bitmap,i,true);
-			break;
-		}
-	}
-
-
-	struct list_item* item = (struct list_item*)malloc(sizeof(struct list_item));
-	item->fd = fd;
-	item->f = f;
-	
-	struct inode *inode = file_get_inode(item->f);
-	if(inode != NULL && inode_dir(inode)){
-		item->dir = dir_open(inode_reopen(inode));
+	struct dir *dir = NULL;
+	struct inode *inode = file_get_inode(f);
+	if(inode != NULL && inode_dir(inode))
+		dir = dir_open(inode_reopen(inode));
+
+	fd = fd_alloc(thread_current(), f, dir);
+	if(fd == -1){
+		if(dir != NULL)
+			dir_close(dir);
+		file_close(f);
+		palloc_free_page(kfile);
+		return -1;
 	}
-	else item->dir = NULL;
-
-	list_push_back(&(thread_current()->file_list),&(item->elem));
 	
-	if(thread_findname_foreach(file))
-		file_deny_write(item->f);
+	/* Opening a running executable gives a read-only descriptor. */
+	if(inode != NULL && inode_is_exec(inode))
+		file_deny_write(f);
+	palloc_free_page(kfile);
 
-	//lock_release(&filesys_lock);
 	return fd;
 }
 int filesize(int fd){
-	if(bitmap_count(thread_current()->file_bitmap,fd,1,false) == 1){
+	struct fd_entry* item = get_fd(thread_current(), fd, true, true);
+	if(item == NULL)
 		return 0;
-	}
-	struct list_elem* elem;
-	struct list_item* item;
-	for(elem = list_begin(&(thread_current()->file_list));
-		elem != list_end(&(thread_current()->file_list)); elem = list_next(elem)){
-		if((item = list_entry(elem,struct list_item,elem))->fd == fd){
-			return file_length(item->f);
-		}
-	}
-	return 0;
+	return file_length(item->f);
 }
 void seek(int fd, unsigned position){
-	if(bitmap_count(thread_current()->file_bitmap,fd,1,false) == 1){
-		return ;
-	}
-	struct list_elem* elem;
-	struct list_item* item;
-	for(elem = list_begin(&(thread_current()->file_list));
-		elem != list_end(&(thread_current()->file_list)); elem = list_next(elem)){
-		if((item = list_entry(elem,struct list_item,elem))->fd == fd){
-			file_seek(item->f,position);
-			break;
-		}
-	}
-
-	return;
+	struct fd_entry* item = get_fd(thread_current(), fd, true, true);
+	if(item != NULL)
+		file_seek(item->f,position);
 }
 unsigned tell(int fd){
-	if(bitmap_count(thread_current()->file_bitmap,fd,1,false) == 1){
+	struct fd_entry* item = get_fd(thread_current(), fd, true, true);
+	if(item == NULL)
 		return 0;
-	}
-	struct list_elem* elem;
-	struct list_item* item;
-	for(elem = list_begin(&(thread_current()->file_list));
-		elem != list_end(&(thread_current()->file_list)); elem = list_next(elem)){
-		if((item = list_entry(elem,struct list_item,elem))->fd == fd){
-			return file_tell(item->f);
-		}
-	}
-	return 0;
+	return file_tell(item->f);
 }
 void close(int fd){
-	//lock_acquire(&filesys_lock);
+	struct thread *t = thread_current();
+	struct fd_entry* item = get_fd(t, fd, true, true);
+	if(item == NULL)
+		return;
+
+	file_close(item->f);
+	if(item->dir)
+		dir_close(item->dir);
+	item->f = NULL;
+	item->dir = NULL;
+	if(fd < t->fd_free)
+		t->fd_free = fd;
+}
+
+/* Copies the statistics of the first CNT system call numbers to
+   USTATS, then clears them if RESET is true.  Returns the number
+   of entries copied, which is less than CNT if there are fewer
+   system calls. */
+int get_syscall_stats(struct syscall_stats *ustats, unsigned cnt, bool reset)
+{
+	struct syscall_stats s;
+	enum intr_level old_level;
+	unsigned i;
+
+	if(cnt > SYSCALL_CNT)
+		cnt = SYSCALL_CNT;
+	if(!check_user_buffer(ustats, cnt * sizeof *ustats, true))
+		exit(-1);
 
-	if(thread_current()->file_bitmap == NULL){
-		thread_current()->file_bitmap = bitmap_create(512);
-		bitmap_set(thread_current()->file_bitmap,0,true);
-		bitmap_set(thread_current()->file_bitmap,1,true);
+	for(i = 0; i < cnt; i++){
+		old_level = intr_disable();
+		s = stats[i];
+		if(reset)
+			memset(&stats[i], 0, sizeof stats[i]);
+		intr_set_level(old_level);
+
+		if(!copy_out(&ustats[i], &s, sizeof s))
+			exit(-1);
 	}
+	return cnt;
+}
 
-	//temporary code in project 2
-	if(fd == 0 || fd == 1){
-		bitmap_set(thread_current()->file_bitmap,fd,false);
+/* Copies the tail of the kernel log, up to SIZE bytes, to
+   BUFFER. */
+int dmesg(char *buffer, unsigned size)
+{
+	char *page;
+	size_t n;
+
+	if(size > PGSIZE)
+		size = PGSIZE;
+	if(!check_user_buffer(buffer, size, true))
+		exit(-1);
+
+	page = palloc_get_page(0);
+	if(page == NULL)
+		return -1;
+	n = klog_read(page, size);
+	if(!copy_out(buffer, page, n)){
+		palloc_free_page(page);
+		exit(-1);
 	}
+	palloc_free_page(page);
+	return n;
+}
 
-	struct list_elem* elem;
-	struct list_item* item;
-	for(elem = list_begin(&(thread_current()->file_list));
-		elem != list_end(&(thread_current()->file_list)); elem = list_next(elem)){
-		if((item = list_entry(elem,struct list_item,elem))->fd == fd){
-			file_close(item->f);
-			if(item->dir)
-				dir_close(item->dir);
-			bitmap_set(thread_current()->file_bitmap,item->fd,false);
-			list_remove(elem);
-			break;
-		}
+/* Carries out one ring submission and returns its result.  A bad
+   buffer or file name fails just that submission with -1, rather
+   than killing the process as the system call itself would. */
+static int ring_submit(const struct ring_sqe *sqe)
+{
+	switch(sqe->op){
+	case RING_OP_NOP:
+		return 0;
+	case RING_OP_READ:
+		if(!check_user_buffer(sqe->buf, sqe->len, true))
+			return -1;
+		return read(sqe->fd, sqe->buf, sqe->len);
+	case RING_OP_WRITE:
+		if(!check_user_buffer(sqe->buf, sqe->len, false))
+			return -1;
+		return write(sqe->fd, sqe->buf, sqe->len);
+	case RING_OP_OPEN:
+		if(sqe->buf == NULL || !check_user_string(sqe->buf))
+			return -1;
+		return open(sqe->buf);
+	case RING_OP_CLOSE:
+		close(sqe->fd);
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+/* Processes the submissions queued on RING in order, posting a
+   completion for each, until the submission ring is empty or the
+   completion ring is full.  The ring stays in user memory; only
+   one entry at a time is copied in or out.  Returns the number of
+   submissions consumed. */
+int ring_enter(struct ring *ring)
+{
+	uint32_t sq_head, sq_tail, cq_head, cq_tail;
+	struct ring_sqe sqe;
+	struct ring_cqe cqe;
+	int cnt = 0;
+
+	if(!copy_in(&sq_head, &ring->sq_head, sizeof sq_head)
+			|| !copy_in(&sq_tail, &ring->sq_tail, sizeof sq_tail)
+			|| !copy_in(&cq_head, &ring->cq_head, sizeof cq_head)
+			|| !copy_in(&cq_tail, &ring->cq_tail, sizeof cq_tail))
+		exit(-1);
+
+	while(sq_head != sq_tail && cq_tail - cq_head < RING_ENTRIES){
+		if(!copy_in(&sqe, &ring->sqes[sq_head % RING_ENTRIES], sizeof sqe))
+			exit(-1);
+		cqe.user_data = sqe.user_data;
+		cqe.res = ring_submit(&sqe);
+		if(!copy_out(&ring->cqes[cq_tail % RING_ENTRIES], &cqe, sizeof cqe))
+			exit(-1);
+		sq_head++;
+		cq_tail++;
+		cnt++;
 	}
-	//lock_release(&filesys_lock);
-	return;
+
+	if(!copy_out(&ring->sq_head, &sq_head, sizeof sq_head)
+			|| !copy_out(&ring->cq_tail, &cq_tail, sizeof cq_tail))
+		exit(-1);
+	return cnt;
 }
 
 #ifdef FILESYS
 
-bool chdir(const char *fname)
+int chdir(const char *fname)
 {
 	bool ret;
+	char *kname = copy_in_string(fname);
 
-	lock_acquire(&filesys_lock);
-
-	ret = filesys_chdir(fname);
-
-	lock_release(&filesys_lock);
+	ret = filesys_chdir(kname);
 
+	palloc_free_page(kname);
 	return ret;
 }
 
-bool mkdir(const char *fname)
+int mkdir(const char *fname)
 {
 	bool ret;
+	char *kname = copy_in_string(fname);
 
-	lock_acquire(&filesys_lock);
-
-	ret = filesys_create(fname, 0, true);
-
-	lock_release(&filesys_lock);
+	ret = filesys_create(kname, 0, true);
 
+	palloc_free_page(kname);
 	return ret;
 }
 
-bool readdir(int fd, char *fname)
+int readdir(int fd, char *fname)
 {
-	struct list_item* item;
+	struct fd_entry* item;
+	char name[NAME_MAX + 1];
 	bool ret = false;
 
-	lock_acquire(&filesys_lock);
+	if (!check_user_buffer(fname, sizeof name, true))
+		exit(-1);
 
 	item = get_fd(thread_current(), fd, true,false);
-
-	if (item == NULL){
-		lock_release(&filesys_lock);
+	if (item == NULL)
 		return false;
-	}
 
 	struct inode *inode;
 	inode = file_get_inode(item->f);
-
-	if (inode == NULL){
-		lock_release(&filesys_lock);
+	if (inode == NULL || !inode_dir(inode))
 		return false;
+
+	ret = dir_readdir(item->dir, name);
+	if (ret && !copy_out(fname, name, strlen(name) + 1))
+		exit(-1);
+	return ret;
+}
+
+int isdir(int fd)
+{
+	struct fd_entry* file_d = get_fd(thread_current(), fd, true,true);
+	return file_d != NULL && inode_dir(file_get_inode(file_d->f));
+}
+
+int inumber(int fd)
+{
+	struct fd_entry* item = get_fd(thread_current(), fd, true, true);
+	return item != NULL ? (int)inode_get_inumber(file_get_inode(item->f)) : -1;
+}
+
+int fsync(int fd)
+{
+	struct fd_entry* item = get_fd(thread_current(), fd, true, true);
+
+	if (item == NULL)
+		return -1;
+
+	file_flush(item->f);
+	return 0;
+}
+
+void sync(void)
+{
+	filesys_sync();
+}
+
+/* Reads at OFS without touching the file position, so unlike
+   read() it needs no file_sema and readers sharing a descriptor
+   proceed in parallel. */
+int pread(int fd, void *buffer, unsigned size, unsigned ofs)
+{
+	if (!check_user_buffer(buffer, size, true))
+		exit(-1);
+
+	struct fd_entry* item = get_fd(thread_current(), fd, false, true);
+	if (item == NULL)
+		return -1;
+	if ((off_t) ofs < 0)
+		return -1;
+
+	uint8_t *p = buffer;
+	unsigned r_size = 0;
+	while (r_size < size) {
+		unsigned n = size - r_size < PIN_CHUNK ? size - r_size : PIN_CHUNK;
+		off_t got;
+		if (!pin_user_buffer(p + r_size, n, true))
+			exit(-1);
+		got = file_read_at(item->f, p + r_size, n, ofs + r_size);
+		unpin_user_pages();
+		r_size += got;
+		if (got < (off_t) n)
+			break;
 	}
+	return r_size;
+}
 
-	if (!inode_dir(inode)){
-		lock_release(&filesys_lock);
-		return false;
+int pwrite(int fd, const void *buffer, unsigned size, unsigned ofs)
+{
+	int w_size;
+
+	if (!check_user_buffer(buffer, size, false))
+		exit(-1);
+
+	struct fd_entry* item = get_fd(thread_current(), fd, false, true);
+	if (item == NULL)
+		return -1;
+	if ((off_t) ofs < 0)
+		return -1;
+
+	const uint8_t *p = buffer;
+	w_size = 0;
+	while ((unsigned) w_size < size) {
+		unsigned n = size - w_size < PIN_CHUNK ? size - w_size : PIN_CHUNK;
+		off_t put;
+		if (!pin_user_buffer(p + w_size, n, false))
+			exit(-1);
+		file_write_sema_down(item->f);
+		put = file_write_at(item->f, p + w_size, n, ofs + w_size);
+		file_write_sema_up(item->f);
+		unpin_user_pages();
+		w_size += put;
+		if (put < (off_t) n)
+			break;
 	}
+	return w_size;
+}
 
-	ret = dir_readdir(item->dir, fname);
+/* Copies the CNT-entry iovec array at UIOV into kernel memory,
+   checking the array and every buffer it names once up front.
+   Kills the process on a bad pointer.  Returns a null pointer if
+   CNT is out of range or the buffers add up to more than a file
+   can hold; the caller must free the copy otherwise. */
+static struct iovec *
+copy_in_iovec(const struct iovec *uiov, int cnt, bool writable)
+{
+	struct iovec *iov;
+	size_t total = 0;
 
-	lock_release(&filesys_lock);
-	return ret;
+	if (cnt <= 0 || cnt > IOV_MAX)
+		return NULL;
+	if (!check_user_range(uiov, cnt * sizeof *iov))
+		exit(-1);
+
+	iov = malloc(cnt * sizeof *iov);
+	if (iov == NULL)
+		return NULL;
+	if (!copy_in(iov, uiov, cnt * sizeof *iov)) {
+		free(iov);
+		exit(-1);
+	}
+
+	for (int i = 0; i < cnt; i++) {
+		if (!check_user_buffer(iov[i].iov_base, iov[i].iov_len, writable)) {
+			free(iov);
+			exit(-1);
+		}
+		if (iov[i].iov_len > INT_MAX - total) {
+			free(iov);
+			return NULL;
+		}
+		total += iov[i].iov_len;
+	}
+	return iov;
 }
 
-bool isdir(int fd)
+/* Pins the buffers in the CNT-entry array IOV, trimming it to
+   PIN_CHUNK bytes in all, and returns the number of entries
+   left.  Kills the process on a bad pointer. */
+static int
+pin_iovec(struct iovec *iov, int cnt, bool writable)
 {
-	lock_acquire(&filesys_lock);
+	size_t left = PIN_CHUNK;
+	int i;
+
+	for (i = 0; i < cnt && left > 0; i++) {
+		if (iov[i].iov_len > left)
+			iov[i].iov_len = left;
+		if (!pin_user_buffer(iov[i].iov_base, iov[i].iov_len, writable)) {
+			free(iov);
+			exit(-1);
+		}
+		left -= iov[i].iov_len;
+	}
+	return i;
+}
 
-	struct list_item* file_d = get_fd(thread_current(), fd, true,true);
-	bool ret = inode_dir(file_get_inode(file_d->f));
+/* Reads into CNT buffers with one fd lookup, one file_sema
+   acquisition and one pass over the file's sectors.  Reads at
+   most PIN_CHUNK bytes, since the buffers stay pinned meanwhile,
+   so a larger request may come up short. */
+int readv(int fd, const struct iovec *uiov, int cnt)
+{
+	struct iovec *iov;
+	int r_size;
 
-	lock_release(&filesys_lock);
-	return ret;
+	if (cnt == 0)
+		return 0;
+	if ((iov = copy_in_iovec(uiov, cnt, true)) == NULL)
+		return -1;
+
+	struct fd_entry* item = get_fd(thread_current(), fd, false, true);
+	if (item == NULL) {
+		free(iov);
+		return -1;
+	}
+
+	cnt = pin_iovec(iov, cnt, true);
+	file_read_sema_down(item->f);
+	r_size = file_readv(item->f, iov, cnt);
+	file_read_sema_up(item->f);
+	unpin_user_pages();
+
+	free(iov);
+	return r_size;
 }
 
-int inumber(int fd)
+/* Writes from CNT buffers, like readv().  Writes at most
+   PIN_CHUNK bytes to a file, but all of them to the console. */
+int writev(int fd, const struct iovec *uiov, int cnt)
 {
-	lock_acquire(&filesys_lock);
-
-	struct list_item* item = NULL;
-	struct thread* t = thread_current();
-
-	struct list_elem *e;
-	if(!list_empty(&t->file_list)){
-		for(e = list_begin(&t->file_list); e != list_end(&t->file_list); e = list_next(e))
-		{
-			struct list_item *temp_item = list_entry(e,struct list_item,elem);
-			if(temp_item->fd == fd){
-				if(item->dir != NULL ){
-					item = temp_item;
-					break;
-				}
-				else if(item->dir == NULL){
-					item =  temp_item;
-					break;
-				}
+	struct iovec *iov;
+	int w_size = 0;
+
+	if (cnt == 0)
+		return 0;
+	if ((iov = copy_in_iovec(uiov, cnt, false)) == NULL)
+		return -1;
+
+	if (fd == 1) {
+		for (int i = 0; i < cnt; i++) {
+			if (!console_write(iov[i].iov_base, iov[i].iov_len)) {
+				free(iov);
+				exit(-1);
 			}
+			w_size += iov[i].iov_len;
 		}
+		free(iov);
+		return w_size;
 	}
-	int ret = (int)inode_get_inumber(file_get_inode(item->f));
-	lock_release(&filesys_lock);
-	return ret;
+
+	struct fd_entry* item = get_fd(thread_current(), fd, false, true);
+	if (item == NULL) {
+		free(iov);
+		return -1;
+	}
+
+	cnt = pin_iovec(iov, cnt, false);
+	file_write_sema_down(item->f);
+	w_size = file_writev(item->f, iov, cnt);
+	file_write_sema_up(item->f);
+	unpin_user_pages();
+
+	free(iov);
+	return w_size;
+}
+
+/* Copies LENGTH bytes from FD_IN to FD_OUT at their current
+   positions without bouncing the data through user memory. */
+int copy_file_range(int fd_in, int fd_out, unsigned length)
+{
+	int c_size;
+
+	if (fd_in == fd_out || (off_t) length < 0)
+		return -1;
+
+	struct fd_entry* in = get_fd(thread_current(), fd_in, false, true);
+	struct fd_entry* out = get_fd(thread_current(), fd_out, false, true);
+	if (in == NULL || out == NULL)
+		return -1;
+
+	file_read_sema_down(in->f);
+	file_write_sema_down(out->f);
+	c_size = file_copy(out->f, in->f, length);
+	file_write_sema_up(out->f);
+	file_read_sema_up(in->f);
+	return c_size;
 }
 #endif
 
-struct list_item* get_fd(struct thread *t,int fd,bool directory,bool file)
+#ifdef VM
+/* Maps the file open as FD at ADDR, to be loaded lazily. */
+int mmap(int fd, void *addr)
 {
-	if(fd <= 2)
+	struct fd_entry* item = get_fd(thread_current(), fd, false, true);
+	if(item == NULL)
+		return -1;
+	return mmap_map(item->f, addr);
+}
+void munmap(int mapid)
+{
+	mmap_unmap(mapid);
+}
+#endif
+
+/* Returns the entry for FD in T's descriptor table, or a null
+   pointer if FD is not open.  An open directory is only returned
+   if DIRECTORY is true, and an open file only if FILE is true.
+   FD_MIN itself is the first descriptor open() hands out, so it
+   is a valid descriptor, not a console one. */
+struct fd_entry* get_fd(struct thread *t,int fd,bool directory,bool file)
+{
+	struct fd_entry *item;
+
+	if(fd < FD_MIN || fd >= t->fd_cap)
 		return NULL;
 
-	struct list_elem *e;
-	if(list_empty(&t->file_list))
+	item = &t->fd_table[fd];
+	if(item->f == NULL)
 		return NULL;
+	if(item->dir != NULL ? directory : file)
+		return item;
+	return NULL;
+}
 
-	for(e = list_begin(&t->file_list); e != list_end(&t->file_list); e = list_next(e))
-	{
-		struct list_item *item = list_entry(e,struct list_item,elem);
-		if(item->fd == fd){
-			if(item->dir != NULL && directory == true )
-			{
-				return item;
-			}
-			else if(item->dir == NULL && file == true )
-			{
-				return item;
-			}
-		}
+/* Installs F, and DIR if it is a directory, at the lowest free
+   descriptor in T's table, growing the table if it is full.
+   Returns the new descriptor, or -1 if none is available. */
+static int fd_alloc(struct thread *t, struct file *f, struct dir *dir)
+{
+	int fd;
+
+	/* Every descriptor below fd_free is in use, so this usually
+	   stops at the first slot it looks at. */
+	for(fd = t->fd_free; fd < t->fd_cap; fd++)
+		if(t->fd_table[fd].f == NULL)
+			break;
+
+	if(fd == t->fd_cap){
+		int cap = t->fd_cap != 0 ? t->fd_cap * 2 : FD_INIT_CNT;
+		struct fd_entry *table;
+
+		if(cap > FD_MAX)
+			cap = FD_MAX;
+		if(fd >= cap)
+			return -1;
+		table = realloc(t->fd_table, cap * sizeof *table);
+		if(table == NULL)
+			return -1;
+		memset(table + t->fd_cap, 0, (cap - t->fd_cap) * sizeof *table);
+		t->fd_table = table;
+		t->fd_cap = cap;
 	}
-	return NULL;
+
+	t->fd_table[fd].f = f;
+	t->fd_table[fd].dir = dir;
+	t->fd_free = fd + 1;
+	return fd;
+}
+
+/* Closes every descriptor of the current process and frees its
+   table. */
+void fd_close_all(void)
+{
+	struct thread *t = thread_current();
+
+	for(int fd = FD_MIN; fd < t->fd_cap; fd++){
+		struct fd_entry *item = &t->fd_table[fd];
+		if(item->f == NULL)
+			continue;
+		file_close(item->f);
+		if(item->dir)
+			dir_close(item->dir);
+	}
+	free(t->fd_table);
+	t->fd_table = NULL;
+	t->fd_cap = 0;
+	t->fd_free = FD_MIN;
 }
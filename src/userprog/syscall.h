@@ -1,7 +1,20 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+/* Descriptors 0 and 1 are the console. */
+#define FD_MIN 2
+
+/* An open descriptor.  DIR is also set if it names a directory.
+   A free slot has a null F. */
+struct fd_entry
+  {
+    struct file *f;
+    struct dir *dir;
+  };
+
 void syscall_init (void);
+void syscall_print_stats (void);
+void fd_close_all (void);
 void halt();
 void exit(int exit_number);
 int exec(const char* filename);
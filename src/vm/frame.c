@@ -1,126 +1,620 @@
 #include "frame.h"
+#include <string.h>
 #include "swap.h"
+#include "filesys/file.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
 
-static struct list frame_list;
+/* Frame table: one entry for every page in the user pool, so
+   the entry for a frame is found by arithmetic on its address
+   and no allocation is needed when a frame is handed out. */
+static struct frame_e *frame_table;
+static size_t frame_cnt;
+static size_t frame_used_cnt;           /* Entries with FRAME_USED. */
 static struct lock frame_lock;
+static struct condition evict_cond;     /* Signaled when an eviction ends. */
 
-struct list_elem *clock;
+/* A page of zeros, mapped read-only in place of any zero-fill
+   page that has been read but not written.  It comes from the
+   kernel pool, so it is never in the frame table or evicted, and
+   must be unmapped before pagedir_destroy() would free it. */
+static void *zero_page;
 
-void init_frame_list(void)
+/* Shared frames, keyed by inode, offset and bytes read, since
+   segments that share a file page may zero different tails of
+   it.  Protected by frame_lock. */
+static struct hash share_table;
+
+static size_t clock_hand;               /* Next entry clock_next() looks at. */
+
+/* Page-out daemon.  When fewer than low_watermark frames are
+   free, it evicts pages until high_watermark frames are free, so
+   that faults normally find a free frame without waiting for a
+   page to be written to swap.  Faults still evict for themselves
+   if the daemon falls behind. */
+static size_t low_watermark;
+static size_t high_watermark;
+static struct semaphore pageout_sema;   /* Upped to wake the daemon. */
+static bool pageout_started;
+static bool pageout_pending;            /* Wakeup posted, not yet handled. */
+
+static struct frame_e* clock_next(void);
+static hash_hash_func share_hash;
+static hash_less_func share_less;
+static void* frame_evict_locked(void);
+static void pageout_daemon(void *aux);
+
+void frame_init(void)
 {
-	list_init(&frame_list);
-	clock = list_begin(&frame_list);
+	frame_cnt = palloc_user_page_cnt();
+	frame_table = calloc(frame_cnt, sizeof *frame_table);
+	if(frame_table == NULL)
+		PANIC("can't allocate frame table");
 	lock_init(&frame_lock);
+	cond_init(&evict_cond);
+	hash_init(&share_table, share_hash, share_less, NULL);
+	zero_page = palloc_get_page(PAL_ASSERT | PAL_ZERO);
+
+	low_watermark = frame_cnt / 32;
+	high_watermark = frame_cnt / 16;
 }
 
-void insert_frame_e(struct list_elem* e)
+/* Starts the page-out daemon.  Must be called after swap is
+   initialized. */
+void pageout_init(void)
 {
-	lock_acquire(&frame_lock);
-	list_push_back(&frame_list,e);
-	lock_release(&frame_lock);
+	sema_init(&pageout_sema, 0);
+	pageout_started = true;
+	thread_create("pageout", PRI_DEFAULT, pageout_daemon, NULL);
 }
 
-struct frame_e* free_frame()
+/* Returns the number of user frames not holding a page. */
+static size_t frame_free_cnt(void)
 {
-	struct frame_e *fe;
-	
-	int j= list_size(&frame_list);
-	for(int i=0; i<=2*j; i++)
+	return frame_cnt - frame_used_cnt;
+}
+
+/* Returns true if there are enough free frames to load pages
+   that nobody has asked for yet. */
+bool frame_plentiful(void)
+{
+	return frame_free_cnt() > high_watermark;
+}
+
+/* Wakes the page-out daemon if free frames have run low. */
+static void pageout_wake(void)
+{
+	if(pageout_started && !pageout_pending
+		&& frame_free_cnt() < low_watermark){
+		pageout_pending = true;
+		sema_up(&pageout_sema);
+	}
+}
+
+/* Clears FE.  The caller must hold frame_lock. */
+static void frame_clear(struct frame_e *fe)
+{
+	if(fe->flags & FRAME_USED)
+		frame_used_cnt--;
+	memset(fe, 0, sizeof *fe);
+}
+
+/* Returns the frame table entry for user pool page KPAGE. */
+static struct frame_e* frame_lookup(void *kpage)
+{
+	return &frame_table[palloc_user_page_idx(kpage)];
+}
+
+/* Returns true if the page in FE has been accessed since the
+   clock last passed it, and clears its accessed bits.  The page
+   is mapped at its user address in its owner's page directory,
+   or in every sharer's, and at KADDR in the kernel's.  The
+   kernel alias is used when the kernel reads or writes it on the
+   owner's behalf, so all of these bits count. */
+static bool frame_accessed(struct frame_e *fe)
+{
+	uint32_t *pd;
+	bool accessed = false;
+
+	if(fe->flags & FRAME_SHARED){
+		struct list_elem *e;
+
+		/* Any sharer's access counts. */
+		for(e = list_begin(&fe->sharers); e != list_end(&fe->sharers);
+			e = list_next(e)){
+			struct spt_e *spte = list_entry(e, struct spt_e, share_elem);
+			pd = spte->owner->pagedir;
+			if(pagedir_is_accessed(pd, spte->vaddr)){
+				accessed = true;
+				pagedir_set_accessed(pd, spte->vaddr, false);
+			}
+		}
+	}
+	else{
+		pd = fe->t->pagedir;
+		accessed = pagedir_is_accessed(pd, fe->spte->vaddr);
+		pagedir_set_accessed(pd, fe->spte->vaddr, false);
+	}
+
+	/* The kernel alias is mapped by page tables that every page
+	   directory shares with the initial one. */
+	if(pagedir_is_accessed(init_page_dir, fe->kaddr)){
+		accessed = true;
+		pagedir_set_accessed(init_page_dir, fe->kaddr, false);
+	}
+	return accessed;
+}
+
+/* Chooses a frame to evict with the clock (second chance)
+   algorithm, across every process's frames.  Returns NULL if no
+   frame can be evicted.  The caller must hold frame_lock. */
+static struct frame_e* free_frame(void)
+{
+	struct frame_e *fe = NULL;
+
+	ASSERT(lock_held_by_current_thread(&frame_lock));
+
+	/* The first lap clears every accessed bit, so the second is
+	   sure to find a victim. */
+	for(size_t i=0; i<=2*frame_cnt; i++)
 	{
 		fe = clock_next();
-		if(pagedir_is_accessed(thread_current()->pagedir,fe->spte->vaddr)){
-			pagedir_set_accessed(thread_current()->pagedir,fe->spte->vaddr,false);	
-		}
-		
-		else{
+		if(fe == NULL || !frame_accessed(fe))
 			break;
-		}
 	}
 	return fe;
 }
 
+/* Records that user pool page KADDR holds SPTE's page.  The
+   frame starts out pinned, because it is not mapped yet and so
+   looks idle to the clock: the caller unpins it once it has
+   filled and mapped it. */
 void add_frame_e(struct spt_e* spte,void *kaddr){
-      	struct frame_e *fe = (struct frame_e*)malloc(sizeof(struct frame_e));
+	struct frame_e *fe = frame_lookup(kaddr);
+
+	lock_acquire(&frame_lock);
+	if(!(fe->flags & FRAME_USED))
+		frame_used_cnt++;
 	fe->kaddr = kaddr;
  	fe->t = thread_current();
 	fe->spte = spte;
-      	insert_frame_e(&fe->elem);	
+	fe->flags = FRAME_USED | FRAME_PINNED;
+	pageout_wake();
+	lock_release(&frame_lock);
+}
+
+/* Advances the clock hand to the next frame that is in use and
+   not pinned, by its loader or a system call, and returns it, or returns NULL if there is none.
+   The caller must hold frame_lock. */
+static struct frame_e* clock_next(void)
+{
+	for(size_t i=0; i<frame_cnt; i++){
+		struct frame_e *fe = &frame_table[clock_hand];
+		clock_hand = (clock_hand + 1) % frame_cnt;
+		if((fe->flags & (FRAME_USED | FRAME_PINNED)) == FRAME_USED
+			&& fe->pin_cnt == 0)
+			return fe;
+	}
+	return NULL;
 }
 
-struct frame_e* clock_next()
+/* Evicts a page and returns its frame, which is handed straight
+   to the caller so that no other thread can take it first.
+   Returns NULL if no frame could be evicted, because none is in
+   use or swap is full.
+
+   A page that still matches its file, because it was loaded from
+   the file and has not been written since, is simply dropped and
+   will be read back on its next fault.  Anything else goes to
+   swap, and from then on the page is anonymous: even once it is
+   back in memory and clean, the file no longer has its data. */
+static void* frame_evict(enum palloc_flags flags)
 {
-	if(clock == NULL || clock == list_end(&frame_list))
-		clock = list_begin(&frame_list);
-	else
-		clock = list_next(&frame_list);
+	void *kaddr;
 
-	//struct frame_e *e = list_entry(clock,struct frame_e,elem);
-	return list_entry(clock,struct frame_e,elem);
+	lock_acquire(&frame_lock);
+	kaddr = frame_evict_locked();
+	lock_release(&frame_lock);
 
-	//return e;
+	if(kaddr != NULL && (flags & PAL_ZERO))
+		memset(kaddr, 0, PGSIZE);
+	return kaddr;
 }
 
-void* frame_allocate(void* upage,enum palloc_flags flags){
+/* Does the work of frame_evict().  The caller must hold
+   frame_lock, which is released while the page is written out,
+   so that other threads can fault and allocate frames meanwhile.
+   The frame stays pinned and marked FRAME_EVICTING until then. */
+static void* frame_evict_locked(void)
+{
+	struct frame_e *fe;
+	struct spt_e *spte;
+	uint32_t *pd;
+	void *kaddr;
+	bool dirty;
+	int swap_slot = -1;
 
-	void *frame = palloc_get_page(PAL_USER|flags);
+	fe = free_frame();
+	if(fe == NULL)
+		return NULL;
 
-	if(frame == NULL){
-		struct frame_e* evicted = free_frame();
-		evicted->spte->swap_slot = swap_to_disk(evicted->kaddr);
-		pagedir_clear_page(evicted->t->pagedir,evicted->spte->vaddr);
-		frame_free(evicted->kaddr);
+	if(fe->flags & FRAME_SHARED){
+		/* Read-only, so the file has the same data.  Just unmap
+		   it everywhere. */
+		while(!list_empty(&fe->sharers)){
+			struct spt_e *spte = list_entry(list_pop_front(&fe->sharers),
+				struct spt_e, share_elem);
+			pagedir_clear_page(spte->owner->pagedir, spte->vaddr);
+			spte->kpage = NULL;
+		}
+		hash_delete(&share_table, &fe->elem);
+		kaddr = fe->kaddr;
+		frame_clear(fe);
+		return kaddr;
+	}
 
-		frame = palloc_get_page(PAL_USER|flags);
+	/* Unmap the page before copying it out, so that its owner
+	   faults, and waits in frame_wait_evicted(), instead of
+	   modifying it behind our back.  Only the user mapping's
+	   dirty bit counts.  Loading the page wrote it through the
+	   kernel alias. */
+	spte = fe->spte;
+	pd = fe->t->pagedir;
+	kaddr = fe->kaddr;
+	dirty = pagedir_is_dirty(pd, spte->vaddr);
+	pagedir_clear_page(pd, spte->vaddr);
+	fe->flags |= FRAME_PINNED | FRAME_EVICTING;
+
+	lock_release(&frame_lock);
+	if(spte->mmap){
+		if(dirty)
+			file_write_at(spte->file, kaddr, spte->page_read_bytes, spte->ofs);
+	}
+	else if(spte->file == NULL || dirty){
+		swap_slot = swap_to_disk(kaddr);
+		if(swap_slot == -1){
+			lock_acquire(&frame_lock);
+			/* Swap is full.  Put the page back as it was. */
+			pagedir_set_page(pd, spte->vaddr, kaddr, spte->writable);
+			pagedir_set_dirty(pd, spte->vaddr, true);
+			fe->flags &= ~(FRAME_PINNED | FRAME_EVICTING);
+			cond_broadcast(&evict_cond, &frame_lock);
+			return NULL;
+		}
+	}
+	lock_acquire(&frame_lock);
+
+	if(swap_slot != -1){
+		spte->swap_slot = swap_slot;
+		spte->file = NULL;
+	}
+	spte->kpage = NULL;
+	frame_clear(fe);
+	cond_broadcast(&evict_cond, &frame_lock);
+	return kaddr;
+}
+
+/* Waits until SPTE's page is not being evicted.  The caller must
+   hold frame_lock. */
+static void wait_evicted_locked(struct spt_e *spte)
+{
+	while(spte->kpage != NULL && !frame_is_zero(spte->kpage)){
+		struct frame_e *fe = frame_lookup(spte->kpage);
+		if(!(fe->flags & FRAME_EVICTING) || fe->spte != spte)
+			break;
+		cond_wait(&evict_cond, &frame_lock);
+	}
+}
+
+/* Waits until SPTE's page, which belongs to the current process,
+   is not being evicted.  Afterward, either the page is mapped
+   again, because it could not be evicted, or SPTE->KPAGE is null
+   and the page is in swap or its file. */
+void frame_wait_evicted(struct spt_e *spte){
+	lock_acquire(&frame_lock);
+	wait_evicted_locked(spte);
+	lock_release(&frame_lock);
+}
+
+/* Evicts pages whenever free frames run low.  frame_lock is
+   released while each page is written out, so faulting threads
+   are not held up by the disk. */
+static void pageout_daemon(void *aux UNUSED)
+{
+	for(;;){
+		sema_down(&pageout_sema);
 
-		if(frame == NULL){
-			printf("frame is NULL\n");
-			exit(-1);
+		lock_acquire(&frame_lock);
+		pageout_pending = false;
+		while(frame_free_cnt() < high_watermark){
+			void *kaddr = frame_evict_locked();
+			if(kaddr == NULL)
+				break;
+			palloc_free_page(kaddr);
 		}
+		lock_release(&frame_lock);
 	}
-	
-	struct spt_e find_e;
-	find_e.vaddr = upage;
-	struct hash_elem *e1 = hash_find(&thread_current()->spt,&find_e.elem);
-	if(e1 == NULL){ //stack growth
-		add_spte(upage,frame,0,0,true,NULL,0);
-		e1 = hash_find(&thread_current()->spt,&find_e.elem);
-		if( e1 == NULL)
-			printf("e1 is NULL\n");
+}
+
+/* Allocates a pinned frame for the current process's page at
+   UPAGE, evicting another page if none is free, and returns its
+   kernel address.  A page not yet in the supplemental page table
+   is new stack.  Returns NULL if no frame is free and none can be
+   evicted. */
+void* frame_allocate(void* upage,enum palloc_flags flags){
+	struct spt_e *spte;
+	void *frame = palloc_get_page(PAL_USER|flags);
+
+	if(frame == NULL){
+		/* The daemon has fallen behind. */
+		frame = frame_evict(flags);
+		if(frame == NULL)
+			return NULL;
 	}
-	struct spt_e* found1 = hash_entry(e1,struct spt_e,elem);
-	add_frame_e(found1,frame);	
 
+	spte = spte_lookup(&thread_current()->spt, upage);
+	if(spte == NULL)
+		spte = add_spte(upage,frame,0,0,true,NULL,0);
+	add_frame_e(spte,frame);
 	return frame;
 }
 
+/* Makes KPAGE, a frame returned by frame_allocate(), eligible
+   for eviction.  Called once the page in it has been mapped. */
+void frame_unpin(void *kpage){
+	struct frame_e *fe = frame_lookup(kpage);
+
+	lock_acquire(&frame_lock);
+	fe->flags &= ~FRAME_PINNED;
+	lock_release(&frame_lock);
+}
+
+/* Pins the frame holding the current process's page at UPAGE
+   until frame_unpin_user_all(), so that a system call can access
+   the page while holding locks that the page fault handler might
+   need.  Returns false if the page is not resident, in which case
+   the caller should touch it and try again. */
+bool frame_pin_user(void *upage){
+	struct thread *t = thread_current();
+	struct spt_e *spte = spte_lookup(&t->spt, upage);
+	bool success = true;
+
+	if(spte == NULL)
+		return true;
+
+	lock_acquire(&frame_lock);
+	if(spte->pinned)
+		;
+	else if(spte->kpage == NULL || pagedir_get_page(t->pagedir, upage) == NULL)
+		success = false;
+	else if(!frame_is_zero(spte->kpage)){
+		/* The zero page is never evicted. */
+		frame_lookup(spte->kpage)->pin_cnt++;
+		spte->pinned = true;
+		list_push_back(&t->pinned_list, &spte->pin_elem);
+	}
+	lock_release(&frame_lock);
+	return success;
+}
+
+/* Releases every pin taken by frame_pin_user() in the current
+   process. */
+void frame_unpin_user_all(void){
+	struct list *pinned = &thread_current()->pinned_list;
+
+	lock_acquire(&frame_lock);
+	while(!list_empty(pinned)){
+		struct spt_e *spte = list_entry(list_pop_front(pinned),
+			struct spt_e, pin_elem);
+		frame_lookup(spte->kpage)->pin_cnt--;
+		spte->pinned = false;
+	}
+	lock_release(&frame_lock);
+}
+
+/* Forgets the frame table entry for KPAGE, which its owner's
+   page directory will free. */
 void frame_free_without_palloc(void* kpage){
+	struct frame_e *fe = frame_lookup(kpage);
 
 	lock_acquire(&frame_lock);
-	struct list_elem *e;
-	for(e = list_begin(&frame_list); e != list_end(&frame_list); e = list_next(e)){
-		struct frame_e *fe = list_entry(e,struct frame_e,elem);
-		if(fe->kaddr == kpage){
-			list_remove(&fe->elem);
-			free(fe);
-			break;
+	frame_clear(fe);
+	lock_release(&frame_lock);
+}
+/* Forgets the frame, if any, that holds SPTE's page, which is
+   being destroyed.  Checked under frame_lock, because the page
+   may be evicted, and its frame reused, at any moment until
+   then. */
+void frame_forget(struct spt_e *spte){
+
+	if(frame_is_zero(spte->kpage)){
+		pagedir_clear_page(spte->owner->pagedir, spte->vaddr);
+		spte->kpage = NULL;
+		return;
+	}
+
+	lock_acquire(&frame_lock);
+	wait_evicted_locked(spte);
+	if(spte->kpage != NULL){
+		struct frame_e *fe = frame_lookup(spte->kpage);
+		if(fe->flags & FRAME_SHARED){
+			/* Keep the owner's pagedir_destroy() from freeing a
+			   frame that other processes still map.  The last
+			   sharer frees it here instead. */
+			pagedir_clear_page(spte->owner->pagedir, spte->vaddr);
+			list_remove(&spte->share_elem);
+			if(list_empty(&fe->sharers)){
+				void *kaddr = fe->kaddr;
+				hash_delete(&share_table, &fe->elem);
+				frame_clear(fe);
+				palloc_free_page(kaddr);
+			}
 		}
+		else if(fe->spte == spte)
+			frame_clear(fe);
+		spte->kpage = NULL;
 	}
 	lock_release(&frame_lock);
 }
-void frame_free(void* kpage){
+
+/* Maps the zero page, read-only, for SPTE in the current
+   process.  Returns true if successful, false if a page table
+   could not be allocated. */
+bool frame_map_zero(struct spt_e *spte){
+	if(!pagedir_set_page(thread_current()->pagedir, spte->vaddr,
+			zero_page, false))
+		return false;
+	spte->kpage = zero_page;
+	return true;
+}
+
+/* Returns true if KPAGE is the zero page. */
+bool frame_is_zero(const void *kpage){
+	return kpage != NULL && kpage == zero_page;
+}
+
+/* Returns true if SPTE's page may be shared with other processes
+   that map the same page of the same file: it is read-only file
+   data that is not part of a memory mapping. */
+static bool shareable(const struct spt_e *spte)
+{
+	return spte->file != NULL && !spte->writable && !spte->mmap;
+}
+
+/* Looks up the shared frame holding the page at OFS in INODE,
+   with READ_BYTES bytes read from it.  The caller must hold
+   frame_lock. */
+static struct frame_e* share_find(struct inode *inode, off_t ofs,
+	size_t read_bytes)
+{
+	struct frame_e key;
+	struct hash_elem *e;
+
+	key.inode = inode;
+	key.ofs = ofs;
+	key.read_bytes = read_bytes;
+	e = hash_find(&share_table, &key.elem);
+	return e != NULL ? hash_entry(e, struct frame_e, elem) : NULL;
+}
+
+/* If another process already has SPTE's page in a shared frame,
+   maps that frame into the current process and returns true.
+   Otherwise returns false, and the caller must load the page
+   itself. */
+bool frame_share_map(struct spt_e *spte){
+	struct frame_e *fe;
+	bool success = false;
+
+	if(!shareable(spte))
+		return false;
 
 	lock_acquire(&frame_lock);
-	struct list_elem *e;
-	for(e = list_begin(&frame_list); e != list_end(&frame_list); e = list_next(e)){
-		struct frame_e *fe = list_entry(e,struct frame_e,elem);
-		if(fe->kaddr == kpage){
-			list_remove(&fe->elem);
-			free(fe);
-			break;
+	fe = share_find(file_get_inode(spte->file), spte->ofs,
+		spte->page_read_bytes);
+	if(fe != NULL && pagedir_set_page(thread_current()->pagedir,
+			spte->vaddr, fe->kaddr, false)){
+		list_push_back(&fe->sharers, &spte->share_elem);
+		spte->kpage = fe->kaddr;
+		success = true;
+	}
+	lock_release(&frame_lock);
+	return success;
+}
+
+/* Offers SPTE's page, just loaded into a private frame, for
+   sharing with other processes. */
+void frame_share(struct spt_e *spte){
+	struct inode *inode;
+	struct frame_e *fe;
+
+	if(!shareable(spte))
+		return;
+
+	lock_acquire(&frame_lock);
+	inode = file_get_inode(spte->file);
+	if(spte->kpage != NULL
+		&& share_find(inode, spte->ofs, spte->page_read_bytes) == NULL){
+		fe = frame_lookup(spte->kpage);
+		if(fe->spte == spte && !(fe->flags & FRAME_PINNED)){
+			fe->flags |= FRAME_SHARED;
+			fe->t = NULL;
+			fe->spte = NULL;
+			fe->inode = inode;
+			fe->ofs = spte->ofs;
+			fe->read_bytes = spte->page_read_bytes;
+			list_init(&fe->sharers);
+			list_push_back(&fe->sharers, &spte->share_elem);
+			hash_insert(&share_table, &fe->elem);
 		}
 	}
-	if(kpage != NULL)
-		palloc_free_page(kpage);	
 	lock_release(&frame_lock);
 }
+
+static unsigned share_hash(const struct hash_elem *e, void *aux UNUSED)
+{
+	const struct frame_e *fe = hash_entry(e, struct frame_e, elem);
+	return hash_bytes(&fe->inode, sizeof fe->inode) ^ hash_int(fe->ofs)
+		^ hash_int(fe->read_bytes);
+}
+
+static bool share_less(const struct hash_elem *a, const struct hash_elem *b,
+	void *aux UNUSED)
+{
+	const struct frame_e *fa = hash_entry(a, struct frame_e, elem);
+	const struct frame_e *fb = hash_entry(b, struct frame_e, elem);
+
+	if(fa->inode != fb->inode)
+		return fa->inode < fb->inode;
+	if(fa->ofs != fb->ofs)
+		return fa->ofs < fb->ofs;
+	return fa->read_bytes < fb->read_bytes;
+}
+/* Unmaps SPTE's page from the current process and frees its
+   frame, if it is resident.  A dirty memory-mapped page is
+   written back to its file first. */
+void frame_release(struct spt_e *spte){
+	uint32_t *pd = thread_current()->pagedir;
+
+	struct frame_e *fe;
+	void *kaddr;
+	bool dirty;
+
+	lock_acquire(&frame_lock);
+	wait_evicted_locked(spte);
+	if(spte->kpage == NULL){
+		lock_release(&frame_lock);
+		return;
+	}
+	kaddr = spte->kpage;
+	fe = frame_lookup(kaddr);
+	dirty = spte->mmap && pagedir_is_dirty(pd, spte->vaddr);
+	pagedir_clear_page(pd, spte->vaddr);
+
+	/* Write back without frame_lock, as frame_evict_locked() does,
+	   keeping the clock away from the frame meanwhile. */
+	if(dirty){
+		if(fe->spte == spte)
+			fe->flags |= FRAME_PINNED | FRAME_EVICTING;
+		lock_release(&frame_lock);
+		file_write_at(spte->file, kaddr, spte->page_read_bytes, spte->ofs);
+		lock_acquire(&frame_lock);
+	}
+
+	if(fe->spte == spte)
+		frame_clear(fe);
+	palloc_free_page(kaddr);
+	spte->kpage = NULL;
+	cond_broadcast(&evict_cond, &frame_lock);
+	lock_release(&frame_lock);
+}
+void frame_free(void* kpage){
+
+	if(kpage == NULL)
+		return;
+	frame_free_without_palloc(kpage);
+	palloc_free_page(kpage);	
+}
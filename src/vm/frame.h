@@ -1,27 +1,59 @@
 #ifndef FRAME_HEADER
 #define FRAME_HEADER
 
+#include <hash.h>
+#include <list.h>
 #include "page.h"
+#include "filesys/off_t.h"
 #include "threads/palloc.h"
 
+/* Frame flags. */
+#define FRAME_USED 0x1                  /* Holds a user page. */
+#define FRAME_SHARED 0x2                /* Mapped by every sharer. */
+#define FRAME_PINNED 0x4                /* Not to be evicted. */
+#define FRAME_EVICTING 0x8              /* Being written out. */
+
+/* One entry per user-pool page, indexed by its position in the
+   pool.
+
+   A frame normally belongs to one page of one process, given by
+   T and SPTE.  A read-only page of a file can instead be shared
+   by every process that maps the same page of the same inode,
+   with the same number of bytes read from it.
+   Then T and SPTE are null, and SHARERS lists the spt_e of each
+   mapping. */
 struct frame_e{
-	struct list_elem elem;
-	struct thread *t;
-	void *kaddr;
-	struct spt_e *spte;
+	struct thread *t;                   /* Owner, if private. */
+	void *kaddr;                        /* Kernel address of the frame. */
+	struct spt_e *spte;                 /* Page it holds, if private. */
+	unsigned flags;                     /* FRAME_* bits. */
+	int pin_cnt;                        /* Pins by system calls in progress. */
+
+	struct inode *inode;                /* File page held, if shared. */
+	off_t ofs;
+	size_t read_bytes;                  /* Rest of the page is zeros. */
+	struct list sharers;                /* spt_e's mapping it, if shared. */
+	struct hash_elem elem;              /* Element in share_table. */
 };
 
-void init_frame_list(void);
-
-void insert_frame_e(struct list_elem *e);
-
-struct frame_e* free_frame();
+void frame_init(void);
+void pageout_init(void);
+bool frame_plentiful(void);
 
 void add_frame_e(struct spt_e* spte,void *kaddr);
-struct frame_e* clock_next();
 
 void* frame_allocate(void* upage,enum palloc_flags flags);
 
+void frame_unpin(void *kpage);
+void frame_wait_evicted(struct spt_e *spte);
+bool frame_pin_user(void *upage);
+void frame_unpin_user_all(void);
 void frame_free(void*);
 void frame_free_without_palloc(void* kpage);
+void frame_forget(struct spt_e *spte);
+void frame_release(struct spt_e *spte);
+bool frame_share_map(struct spt_e *spte);
+bool frame_map_zero(struct spt_e *spte);
+bool frame_is_zero(const void *kpage);
+void frame_share(struct spt_e *spte);
 #endif
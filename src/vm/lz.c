@@ -0,0 +1,128 @@
+#include "lz.h"
+#include <stdint.h>
+#include <string.h>
+#include "threads/vaddr.h"
+
+/* A byte-oriented LZ77 coder in the style of LZRW1, chosen for
+   speed over ratio: one hash probe per input position and no
+   entropy coding.
+
+   Output is a series of groups, each a control byte followed by
+   up to 8 items.  Bit N of the control byte, starting from the
+   least significant bit, describes item N:
+
+        0  A literal byte.
+        1  A 2-byte back-reference: a 12-bit distance (1...4095)
+           then a 4-bit length less LZ_MIN_MATCH (3...18),
+           most significant bits first.
+
+   Back-references may overlap the bytes they produce, so a run
+   of one repeated byte codes as a literal followed by
+   references with distance 1. */
+
+#define LZ_HASH_BITS 12
+#define LZ_MIN_MATCH 3
+#define LZ_MAX_MATCH (LZ_MIN_MATCH + 15)
+#define LZ_MAX_DIST 4095
+
+/* Most recent position + 1 of each hashed 3-byte prefix, or 0.
+   Not reentrant: callers serialize on their own lock. */
+static uint16_t lz_table[1 << LZ_HASH_BITS];
+
+static unsigned
+hash3(const uint8_t *p)
+{
+	uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16);
+	return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/* Compresses the page at PAGE into DST.  Returns the compressed
+   size, or 0 if it would exceed DST_MAX bytes. */
+size_t
+lz_compress(const void *page, void *dst_, size_t dst_max)
+{
+	const uint8_t *src = page;
+	uint8_t *dst = dst_;
+	size_t ip = 0, op = 0, ctrl = 0;
+	int bit = 8;
+
+	memset(lz_table, 0, sizeof lz_table);
+	while (ip < PGSIZE) {
+		size_t len = 0, dist = 0;
+
+		if (bit == 8) {
+			if (op >= dst_max)
+				return 0;
+			ctrl = op++;
+			dst[ctrl] = 0;
+			bit = 0;
+		}
+
+		if (ip + LZ_MIN_MATCH <= PGSIZE) {
+			unsigned h = hash3(src + ip);
+			size_t cand = lz_table[h];
+
+			lz_table[h] = ip + 1;
+			if (cand != 0 && ip - (cand - 1) <= LZ_MAX_DIST) {
+				cand--;
+				while (len < LZ_MAX_MATCH && ip + len < PGSIZE
+					&& src[cand + len] == src[ip + len])
+					len++;
+				dist = ip - cand;
+			}
+		}
+
+		if (len >= LZ_MIN_MATCH) {
+			if (op + 2 > dst_max)
+				return 0;
+			dst[ctrl] |= 1 << bit;
+			dst[op++] = dist >> 4;
+			dst[op++] = ((dist & 0xf) << 4) | (len - LZ_MIN_MATCH);
+			ip += len;
+		} else {
+			if (op + 1 > dst_max)
+				return 0;
+			dst[op++] = src[ip++];
+		}
+		bit++;
+	}
+	return op;
+}
+
+/* Decompresses SRC_LEN bytes at SRC into the page at PAGE.
+   Returns false if SRC is not a valid compressed page. */
+bool
+lz_decompress(const void *src_, size_t src_len, void *page)
+{
+	const uint8_t *src = src_;
+	uint8_t *dst = page;
+	size_t ip = 0, op = 0;
+
+	while (op < PGSIZE) {
+		uint8_t ctrl;
+
+		if (ip >= src_len)
+			return false;
+		ctrl = src[ip++];
+		for (int bit = 0; bit < 8 && op < PGSIZE; bit++) {
+			if (ctrl & (1 << bit)) {
+				size_t dist, len;
+
+				if (ip + 2 > src_len)
+					return false;
+				dist = (src[ip] << 4) | (src[ip + 1] >> 4);
+				len = (src[ip + 1] & 0xf) + LZ_MIN_MATCH;
+				ip += 2;
+				if (dist == 0 || dist > op || op + len > PGSIZE)
+					return false;
+				for (; len > 0; len--, op++)
+					dst[op] = dst[op - dist];
+			} else {
+				if (ip >= src_len)
+					return false;
+				dst[op++] = src[ip++];
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,12 @@
+#ifndef LZ_HEADER
+#define LZ_HEADER
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* LZ77 compression of single pages.  Each compresses or
+   decompresses exactly PGSIZE bytes. */
+size_t lz_compress(const void *page, void *dst, size_t dst_max);
+bool lz_decompress(const void *src, size_t src_len, void *page);
+
+#endif
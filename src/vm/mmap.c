@@ -0,0 +1,109 @@
+#include "mmap.h"
+#include <round.h>
+#include "filesys/file.h"
+#include "frame.h"
+#include "page.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+
+/* Memory-mapped files.
+
+   Mapping a file only adds an spt_e per page, with spte->mmap
+   set; nothing is read until the page faults.  A dirty mapped
+   page is written back to the file, never to swap, when it is
+   evicted and when the mapping goes away through munmap or
+   process exit.  Clean pages are simply dropped. */
+
+static void unmap(struct mmap_e *m);
+
+/* Maps FILE at ADDR in the current process.  Returns the new
+   mapping's identifier, or -1 if FILE is empty, ADDR is not a
+   page-aligned user address, or the range would overlap any page
+   already in use, including the stack. */
+int mmap_map(struct file *file, void *addr)
+{
+	struct thread *t = thread_current();
+	off_t length = file_length(file);
+	struct mmap_e *m;
+	size_t i;
+
+	if(length == 0 || addr == NULL || pg_ofs(addr) != 0)
+		return -1;
+
+	size_t page_cnt = DIV_ROUND_UP(length, PGSIZE);
+	for(i = 0; i < page_cnt; i++){
+		void *upage = (uint8_t *) addr + i * PGSIZE;
+		if(!is_user_vaddr(upage) || spte_lookup(&t->spt, upage) != NULL)
+			return -1;
+	}
+
+	m = malloc(sizeof *m);
+	if(m == NULL)
+		return -1;
+	m->file = file_reopen(file);
+	if(m->file == NULL){
+		free(m);
+		return -1;
+	}
+	m->id = t->next_mapid++;
+	m->addr = addr;
+	m->page_cnt = page_cnt;
+
+	for(i = 0; i < page_cnt; i++){
+		off_t ofs = i * PGSIZE;
+		size_t read_bytes = length - ofs < PGSIZE ? length - ofs : PGSIZE;
+		struct spt_e *spte = add_spte((uint8_t *) addr + ofs, NULL, read_bytes,
+			PGSIZE - read_bytes, true, m->file, ofs);
+		spte->mmap = true;
+	}
+	list_push_back(&t->mmap_list, &m->elem);
+
+	return m->id;
+}
+
+/* Unmaps the current process's mapping ID, writing back any
+   dirty pages.  Returns false if there is no such mapping. */
+bool mmap_unmap(int id)
+{
+	struct thread *t = thread_current();
+	struct list_elem *e;
+
+	for(e = list_begin(&t->mmap_list); e != list_end(&t->mmap_list);
+		e = list_next(e)){
+		struct mmap_e *m = list_entry(e, struct mmap_e, elem);
+		if(m->id == id){
+			unmap(m);
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Unmaps all of the current process's mappings.  Called at exit,
+   while its page directory is still in place. */
+void mmap_unmap_all(void)
+{
+	struct thread *t = thread_current();
+
+	while(!list_empty(&t->mmap_list))
+		unmap(list_entry(list_front(&t->mmap_list), struct mmap_e, elem));
+}
+
+static void unmap(struct mmap_e *m)
+{
+	struct thread *t = thread_current();
+
+	for(size_t i = 0; i < m->page_cnt; i++){
+		void *upage = (uint8_t *) m->addr + i * PGSIZE;
+		struct spt_e *spte = spte_lookup(&t->spt, upage);
+
+		frame_release(spte);
+		hash_delete(&t->spt, &spte->elem);
+		free(spte);
+	}
+	list_remove(&m->elem);
+	file_close(m->file);
+	free(m);
+}
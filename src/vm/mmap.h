@@ -0,0 +1,23 @@
+#ifndef MMAP_HEADER
+#define MMAP_HEADER
+
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+struct file;
+
+/* A memory-mapped file. */
+struct mmap_e{
+	int id;                             /* Mapping identifier. */
+	struct file *file;                  /* Private reopening of the file. */
+	void *addr;                         /* First page. */
+	size_t page_cnt;                    /* Number of pages. */
+	struct list_elem elem;              /* Element in thread's mmap_list. */
+};
+
+int mmap_map(struct file *file, void *addr);
+bool mmap_unmap(int id);
+void mmap_unmap_all(void);
+
+#endif
@@ -1,5 +1,6 @@
 #include "page.h"
 #include "frame.h"
+#include "swap.h"
 #include "threads/vaddr.h"
 
 unsigned hash_value(const struct hash_elem* e,void *aux)
@@ -20,13 +21,13 @@ void spte_destroy(struct hash_elem *elem,void *aux)
 {
 	struct spt_e *spte = hash_entry(elem,struct spt_e,elem);
 
-	if(spte->kpage != NULL){
-		frame_free_without_palloc(spte->kpage);	
-	}
+	frame_forget(spte);
+	if(spte->swap_slot != -1)
+		swap_free(spte->swap_slot);
 	free(spte);
 }
 
-void add_spte(void* upage,void* kpage,size_t page_read_bytes,size_t page_zero_bytes,bool writable,struct file* file,size_t ofs){
+struct spt_e* add_spte(void* upage,void* kpage,size_t page_read_bytes,size_t page_zero_bytes,bool writable,struct file* file,size_t ofs){
 	struct spt_e *spte = (struct spte *)malloc(sizeof(struct spt_e)); //insert spte
 	spte->vaddr = upage;
 	spte->kpage = kpage;
@@ -36,5 +37,19 @@ void add_spte(void* upage,void* kpage,size_t page_read_bytes,size_t page_zero_by
  	spte->file = file;
  	spte->ofs = ofs;
 	spte->swap_slot = -1;
+	spte->mmap = false;
+	spte->pinned = false;
+	spte->owner = thread_current();
 	hash_insert(&thread_current()->spt,&(spte->elem));
+	return spte;
+}
+
+/* Returns the entry for UPAGE in SPT, or NULL if there is none. */
+struct spt_e* spte_lookup(struct hash *spt,void *upage){
+	struct spt_e find_e;
+	struct hash_elem *e;
+
+	find_e.vaddr = upage;
+	e = hash_find(spt,&find_e.elem);
+	return e != NULL ? hash_entry(e,struct spt_e,elem) : NULL;
 }
@@ -9,10 +9,15 @@ struct spt_e{
 	size_t page_read_bytes;
 	size_t page_zero_bytes;
 	bool writable;
-	struct file* file;
+	struct file* file;                  /* Backing file, NULL once swapped. */
 	struct hash_elem elem;
 	size_t ofs;
 	int swap_slot;
+	bool mmap;                          /* Written back to file, not swap. */
+	struct thread *owner;               /* Process it belongs to. */
+	struct list_elem share_elem;        /* In a shared frame's sharers. */
+	bool pinned;                        /* In owner's pinned_list? */
+	struct list_elem pin_elem;          /* In owner's pinned_list. */
 };
 
 unsigned hash_value(const struct hash_elem* e,void *aux);
@@ -21,6 +26,7 @@ bool hash_compare(const struct hash_elem *a,const struct hash_elem *b,void *aux)
 
 void spte_destroy(struct hash_elem *elem,void *aux);
 
-void add_spte(void* upage,void* kpage,size_t page_read_bytes,size_t page_zero_bytes,bool writable,struct file* file,size_t ofs);
+struct spt_e* add_spte(void* upage,void* kpage,size_t page_read_bytes,size_t page_zero_bytes,bool writable,struct file* file,size_t ofs);
+struct spt_e* spte_lookup(struct hash *spt,void *upage);
 
 #endif
@@ -1,22 +1,110 @@
 #include "swap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <string.h>
 #include "devices/block.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
 #include "threads/vaddr.h"
-#include "lib/kernel/bitmap.h"
+#include "lz.h"
 
-static struct bitmap *swap_bitmap;
+/* Each swap slot holds one page. */
+#define SECTORS_PER_SLOT (PGSIZE / BLOCK_SECTOR_SIZE)
 
-void init_swap_bitmap()
+static struct block *swap_block;
+static struct bitmap *swap_bitmap;      /* Slots in use. */
+static struct lock swap_lock;           /* Protects everything here. */
+
+/* Compressed swap cache.
+
+   A page sent to swap is first compressed into an arena of
+   ZSWAP_PAGES kernel pages, and only reaches its slot on the
+   swap device when the arena has no room for newer pages: then
+   the oldest cached pages are written back to make room.
+   Reading a cached page back is a decompression instead of
+   SECTORS_PER_SLOT disk reads.  Pages that do not compress to
+   ZSWAP_MAX_LEN bytes or less go straight to the device.
+
+   Every cached page still owns a slot on the device, so the
+   cache never changes how many pages fit in swap.
+
+   The arena is divided into ZSWAP_CHUNK-byte chunks, allocated
+   in contiguous runs with zswap_map. */
+#ifndef ZSWAP_PAGES
+#define ZSWAP_PAGES 64
+#endif
+#define ZSWAP_CHUNK 64
+#define ZSWAP_CHUNK_CNT (ZSWAP_PAGES * PGSIZE / ZSWAP_CHUNK)
+#define ZSWAP_MAX_LEN (PGSIZE / 2)
+
+/* Where a slot's page is in the cache. */
+struct zswap_e{
+	uint32_t chunk;                     /* First chunk. */
+	uint16_t len;                       /* Compressed size, 0 if not cached. */
+	bool writing;                       /* Being written back to the device? */
+	struct list_elem elem;              /* In zswap_lru. */
+};
+
+static uint8_t *zswap_arena;
+static struct bitmap *zswap_map;        /* Chunks in use. */
+static struct zswap_e *zswap_table;     /* Indexed by slot. */
+static struct list zswap_lru;           /* Cached slots, oldest first. */
+static uint8_t *zswap_buf;              /* One page of scratch space. */
+static struct condition zswap_cond;     /* Signaled when a write-back ends. */
+
+static int find_swap_slot(void);
+static bool zswap_store(int swap_slot, const void *kaddr);
+static bool zswap_load(int swap_slot, void *kaddr);
+static void zswap_drop(int swap_slot);
+static void zswap_wait(int swap_slot);
+static void write_slot(int swap_slot, const void *kaddr);
+
+/* Sizes the slot map to the swap device and sets up the
+   compressed cache in front of it.  Without a device, there are
+   no slots and every swap_to_disk() fails. */
+void init_swap_bitmap(void)
 {
-	swap_bitmap = bitmap_create(1024);
+	size_t slot_cnt = 0;
+
+	swap_block = block_get_role(BLOCK_SWAP);
+	if(swap_block != NULL)
+		slot_cnt = block_size(swap_block) / SECTORS_PER_SLOT;
+
+	swap_bitmap = bitmap_create(slot_cnt);
+	if(swap_bitmap == NULL)
+		PANIC("can't allocate swap slot map");
+	lock_init(&swap_lock);
+
+	list_init(&zswap_lru);
+	cond_init(&zswap_cond);
+	if(slot_cnt == 0)
+		return;
+	zswap_arena = palloc_get_multiple(0, ZSWAP_PAGES);
+	zswap_buf = palloc_get_page(0);
+	zswap_map = bitmap_create(ZSWAP_CHUNK_CNT);
+	zswap_table = calloc(slot_cnt, sizeof *zswap_table);
+	if(zswap_arena == NULL || zswap_buf == NULL || zswap_map == NULL
+		|| zswap_table == NULL)
+		PANIC("can't allocate compressed swap cache");
 }
-void destroy_swap_bitmap()
+void destroy_swap_bitmap(void)
 {
 	bitmap_destroy(swap_bitmap);
 }
 
-int find_swap_slot()
+/* Claims a free slot.  Returns its index, or -1 if swap is
+   full. */
+static int find_swap_slot(void)
 {
-	int swap_idx = bitmap_scan(swap_bitmap,0,1,false);
+	size_t swap_idx;
+
+	lock_acquire(&swap_lock);
+	swap_idx = bitmap_scan_and_flip(swap_bitmap,0,1,false);
+	lock_release(&swap_lock);
 
 	if(swap_idx != BITMAP_ERROR)
 		return swap_idx;
@@ -27,27 +115,161 @@ int find_swap_slot()
 int swap_to_disk(void* kaddr){
 
 	ASSERT(kaddr >= PHYS_BASE);
-	struct block* b = block_get_role(BLOCK_SWAP);
 	int swap_slot = find_swap_slot();
+	bool cached;
 
 	if(swap_slot == -1){
 		return -1;
 	}
 
-	for(int i=0; i<8; i++){
-		block_write(b,swap_slot*8 + i,kaddr +(i*BLOCK_SECTOR_SIZE));
-	}
-	bitmap_set(swap_bitmap,swap_slot,true);
-	
+	lock_acquire(&swap_lock);
+	cached = zswap_store(swap_slot, kaddr);
+	lock_release(&swap_lock);
+
+	if(!cached)
+		write_slot(swap_slot, kaddr);
 	return swap_slot;
 }
 
+/* Reads SWAP_SLOT into KADDR and frees the slot. */
 void swap_to_addr(int swap_slot,void * kaddr){
-	
-	struct block* b = block_get_role(BLOCK_SWAP);
+	bool cached;
+
+	lock_acquire(&swap_lock);
+	cached = zswap_load(swap_slot, kaddr);
+	lock_release(&swap_lock);
+
+	/* A slot that is not cached is not written back to while we
+	   read it: it is already on the device. */
+	if(!cached)
+		for(int i=0; i<SECTORS_PER_SLOT; i++)
+			block_read(swap_block,swap_slot*SECTORS_PER_SLOT+i,kaddr+(i*BLOCK_SECTOR_SIZE));	
+	swap_free(swap_slot);
+}
+
+/* Frees SWAP_SLOT without reading it, for a page that is being
+   destroyed. */
+void swap_free(int swap_slot){
+
+	lock_acquire(&swap_lock);
+	ASSERT(bitmap_test(swap_bitmap,swap_slot));
+	zswap_wait(swap_slot);
+	zswap_drop(swap_slot);
+	bitmap_reset(swap_bitmap,swap_slot);
+	lock_release(&swap_lock);
+}
+
+/* Writes the page at KADDR to SWAP_SLOT on the device. */
+static void write_slot(int swap_slot, const void *kaddr){
 
-	for(int i=0; i<8; i++)
-		block_read(b,swap_slot*8+i,kaddr+(i*BLOCK_SECTOR_SIZE));	
-	bitmap_set(swap_bitmap,swap_slot,false);
+	for(int i=0; i<SECTORS_PER_SLOT; i++){
+		block_write(swap_block,swap_slot*SECTORS_PER_SLOT + i,(const uint8_t *) kaddr +(i*BLOCK_SECTOR_SIZE));
+	}
 }
 
+/* Drops the oldest page in the cache and writes it back to its
+   slot on the device.  Returns false if the cache is empty or
+   there is no page free to decompress it into.
+
+   The caller must hold swap_lock, which is released during the
+   disk writes.  Meanwhile the slot is marked as being written,
+   and zswap_wait() holds off anyone else who wants it. */
+static bool zswap_writeback(void){
+	struct zswap_e *z;
+	uint8_t *page;
+	int slot;
+
+	if(list_empty(&zswap_lru))
+		return false;
+	page = palloc_get_page(0);
+	if(page == NULL)
+		return false;
+
+	z = list_entry(list_front(&zswap_lru), struct zswap_e, elem);
+	slot = z - zswap_table;
+	if(!lz_decompress(zswap_arena + z->chunk * ZSWAP_CHUNK, z->len, page))
+		PANIC("compressed swap cache is corrupt");
+	zswap_drop(slot);
+	z->writing = true;
+
+	lock_release(&swap_lock);
+	write_slot(slot, page);
+	lock_acquire(&swap_lock);
+
+	z->writing = false;
+	cond_broadcast(&zswap_cond, &swap_lock);
+	palloc_free_page(page);
+	return true;
+}
+
+/* Waits until SWAP_SLOT is not being written back.  The caller
+   must hold swap_lock. */
+static void zswap_wait(int swap_slot){
+	if(zswap_table == NULL)
+		return;
+	while(zswap_table[swap_slot].writing)
+		cond_wait(&zswap_cond, &swap_lock);
+}
+
+/* Compresses the page at KADDR into the cache as SWAP_SLOT,
+   writing older pages back to make room if necessary.  Returns
+   false if the page does not compress well enough to be worth
+   caching.  The caller must hold swap_lock. */
+static bool zswap_store(int swap_slot, const void *kaddr){
+	struct zswap_e *z;
+	size_t len, chunk_cnt, chunk;
+
+	if(zswap_arena == NULL)
+		return false;
+	len = lz_compress(kaddr, zswap_buf, ZSWAP_MAX_LEN);
+	if(len == 0)
+		return false;
+
+	chunk_cnt = DIV_ROUND_UP(len, ZSWAP_CHUNK);
+	while((chunk = bitmap_scan_and_flip(zswap_map, 0, chunk_cnt, false))
+		== BITMAP_ERROR){
+		/* Others may use zswap_buf while write-back has
+		   swap_lock released, so compress again afterward. */
+		if(!zswap_writeback())
+			return false;
+		len = lz_compress(kaddr, zswap_buf, ZSWAP_MAX_LEN);
+	}
+
+	z = &zswap_table[swap_slot];
+	z->chunk = chunk;
+	z->len = len;
+	memcpy(zswap_arena + chunk * ZSWAP_CHUNK, zswap_buf, len);
+	list_push_back(&zswap_lru, &z->elem);
+	return true;
+}
+
+/* If SWAP_SLOT is cached, decompresses it into KADDR, drops it
+   from the cache and returns true.  Otherwise returns false, once
+   the page is sure to be on the device.  The caller must hold
+   swap_lock. */
+static bool zswap_load(int swap_slot, void *kaddr){
+	struct zswap_e *z;
+
+	zswap_wait(swap_slot);
+	if(zswap_table == NULL || zswap_table[swap_slot].len == 0)
+		return false;
+	z = &zswap_table[swap_slot];
+	if(!lz_decompress(zswap_arena + z->chunk * ZSWAP_CHUNK, z->len, kaddr))
+		PANIC("compressed swap cache is corrupt");
+	zswap_drop(swap_slot);
+	return true;
+}
+
+/* Drops SWAP_SLOT from the cache, if it is there.  The caller
+   must hold swap_lock. */
+static void zswap_drop(int swap_slot){
+	struct zswap_e *z;
+
+	if(zswap_table == NULL || zswap_table[swap_slot].len == 0)
+		return;
+	z = &zswap_table[swap_slot];
+	bitmap_set_multiple(zswap_map, z->chunk,
+		DIV_ROUND_UP(z->len, ZSWAP_CHUNK), false);
+	list_remove(&z->elem);
+	z->len = 0;
+}
@@ -1,10 +1,10 @@
 #ifndef SWAP_HEADER
 #define SWAP_HEADER
 
-int find_swap_slot(); //return -1 if no swapslot, return n if there is swapslot to use with index n.
-void init_swap_bitmap();
-void destroy_swap_bitmap();
+void init_swap_bitmap(void);
+void destroy_swap_bitmap(void);
 
-int swap_to_disk(void* kaddr);
+int swap_to_disk(void* kaddr); //return the slot written, or -1 if swap is full.
 void swap_to_addr(int swap_slot,void * kaddr);
+void swap_free(int swap_slot);
 #endif